@@ -0,0 +1,217 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "aol.h"
+#include "metrics.h"
+
+// Initialize mailbox
+void init_mailbox(Mailbox *mailbox) {
+    mailbox->head = 0;
+    mailbox->tail = 0;
+    mailbox->closed = false;
+    pthread_mutex_init(&mailbox->lock, NULL);
+
+    // Timed receives wait on CLOCK_MONOTONIC so a wall clock step cannot stretch or skip them
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&mailbox->not_empty, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&mailbox->not_full, NULL);
+}
+
+// Send a log entry to the mailbox
+void send_message(Mailbox *mailbox, LogEntry entry) {
+    METRIC_TIMER_START(timer);
+    pthread_mutex_lock(&mailbox->lock);
+    if ((mailbox->tail + 1) % MAILBOX_SIZE == mailbox->head) {
+        METRIC_INC(METRIC_MAILBOX_SEND_BLOCKED);
+        METRIC_TRACE(mailbox_send_blocked, mailbox);
+    }
+    while ((mailbox->tail + 1) % MAILBOX_SIZE == mailbox->head) {
+        pthread_cond_wait(&mailbox->not_full, &mailbox->lock);
+    }
+    mailbox->entries[mailbox->tail] = entry;
+    mailbox->tail = (mailbox->tail + 1) % MAILBOX_SIZE;
+    METRIC_RECORD(METRIC_MAILBOX_DEPTH, (mailbox->tail - mailbox->head + MAILBOX_SIZE) % MAILBOX_SIZE);
+    pthread_cond_signal(&mailbox->not_empty);
+    pthread_mutex_unlock(&mailbox->lock);
+    METRIC_INC(METRIC_MAILBOX_SENT);
+    METRIC_TIMER_STOP(METRIC_MAILBOX_SEND_LATENCY, timer);
+}
+
+// Receive a log entry from the mailbox
+LogEntry receive_message(Mailbox *mailbox) {
+    LogEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    receive_message_timed(mailbox, &entry, NULL);
+    return entry;
+}
+
+// Receive a log entry, giving up at deadline (CLOCK_MONOTONIC, NULL to wait forever).
+// Returns 0 with an entry, ETIMEDOUT at the deadline, or EPIPE once the mailbox is closed and drained
+int receive_message_timed(Mailbox *mailbox, LogEntry *entry, const struct timespec *deadline) {
+    METRIC_TIMER_START(timer);
+    pthread_mutex_lock(&mailbox->lock);
+    if (mailbox->head == mailbox->tail && !mailbox->closed) {
+        METRIC_INC(METRIC_MAILBOX_RECEIVE_BLOCKED);
+        METRIC_TRACE(mailbox_receive_blocked, mailbox);
+    }
+    while (mailbox->head == mailbox->tail) {
+        if (mailbox->closed) {
+            pthread_mutex_unlock(&mailbox->lock);
+            return EPIPE;
+        }
+        if (deadline == NULL) {
+            pthread_cond_wait(&mailbox->not_empty, &mailbox->lock);
+        } else if (pthread_cond_timedwait(&mailbox->not_empty, &mailbox->lock, deadline) == ETIMEDOUT &&
+                   mailbox->head == mailbox->tail && !mailbox->closed) {
+            pthread_mutex_unlock(&mailbox->lock);
+            return ETIMEDOUT;
+        }
+    }
+    *entry = mailbox->entries[mailbox->head];
+    mailbox->head = (mailbox->head + 1) % MAILBOX_SIZE;
+    pthread_cond_signal(&mailbox->not_full);
+    pthread_mutex_unlock(&mailbox->lock);
+    METRIC_INC(METRIC_MAILBOX_RECEIVED);
+    METRIC_TIMER_STOP(METRIC_MAILBOX_RECEIVE_LATENCY, timer);
+    return 0;
+}
+
+// Close the mailbox: receivers drain what is queued, then get EPIPE instead of blocking
+void close_mailbox(Mailbox *mailbox) {
+    pthread_mutex_lock(&mailbox->lock);
+    mailbox->closed = true;
+    pthread_cond_broadcast(&mailbox->not_empty);
+    pthread_mutex_unlock(&mailbox->lock);
+}
+
+// Check if log file is empty
+bool is_file_empty(const char *filename) {
+    struct stat st;
+    if (stat(filename, &st) == 0) {
+        return st.st_size == 0;
+    }
+    return true;
+}
+
+// Append a preformatted JSON object to the array in the log file
+int append_json_to_log(const char *object) {
+    FILE *file = fopen(LOG_FILE, "r+");
+    if (file == NULL) {
+        // If the file doesn't exist, create it
+        file = fopen(LOG_FILE, "w");
+        if (file == NULL) {
+            perror("fopen");
+            return -1;
+        }
+    }
+
+    // Lock the file for writing (exclusive lock)
+    int fd = fileno(file);
+    if (flock(fd, LOCK_EX) != 0) {
+        perror("flock");
+        fclose(file);
+        return -1;
+    }
+
+    // Check if the file is empty
+    bool first_entry = is_file_empty(LOG_FILE);
+
+    // If it's a new file, start the JSON array
+    if (first_entry) {
+        fprintf(file, "[\n");
+    } else {
+        // Move the file pointer to just before the closing bracket
+        fseek(file, -2, SEEK_END);
+        fprintf(file, ",\n");
+    }
+
+    // Append the object and close the array again
+    fprintf(file, "%s\n]", object);
+
+    // Unlock the file after writing
+    if (flock(fd, LOCK_UN) != 0) {
+        perror("flock");
+        fclose(file);
+        return -1;
+    }
+
+    if (fclose(file) != 0) {
+        perror("fclose");
+        return -1;
+    }
+    return 0;
+}
+
+// Append a formatted record, timing it and counting failures
+static int append_record(const char *object, unsigned long timestamp) {
+    METRIC_TIMER_START(timer);
+    int rc = append_json_to_log(object);
+    METRIC_TIMER_STOP(METRIC_AOL_APPEND_LATENCY, timer);
+    if (rc != 0) {
+        METRIC_INC(METRIC_AOL_APPEND_ERRORS);
+        METRIC_TRACE(aol_append_error, timestamp);
+    }
+    return rc;
+}
+
+// Append log entry as JSON to the log file, returning 0 on success and -1 on failure
+int append_to_log(LogEntry entry) {
+    char object[MAX_LOG_ENTRY_SIZE + 64];
+
+    // Format the log entry as a JSON object
+    snprintf(object, sizeof(object), "  {\n    \"timestamp\": %lu,\n    \"log_entry\": \"%s\"\n  }", entry.timestamp, entry.log_entry);
+    return append_record(object, entry.timestamp);
+}
+
+// Append log entry as JSON with its position in the verifiable log, returning 0 on success and -1 on failure
+int append_indexed_to_log(LogEntry entry, unsigned long index) {
+    char object[MAX_LOG_ENTRY_SIZE + 96];
+
+    snprintf(object, sizeof(object), "  {\n" LOG_INDEX_FIELD "%lu,\n    \"timestamp\": %lu,\n    \"log_entry\": \"%s\"\n  }",
+             index, entry.timestamp, entry.log_entry);
+    return append_record(object, entry.timestamp);
+}
+
+// Actor thread function to handle log entries
+void *actor(void *arg) {
+    Mailbox *mailbox = (Mailbox *)arg;
+
+    while (1) {
+        // Receive log entry from mailbox
+        LogEntry entry = receive_message(mailbox);
+        // Append entry to the log file; failures are reported and counted, and the actor keeps running
+        append_to_log(entry);
+    }
+}
+
+// Timestamp generator (CRDT-like ordering)
+unsigned long get_timestamp() {
+    static unsigned long lamport_clock = 0;
+    return ++lamport_clock;
+}
+
+// Read the log file
+void read_log() {
+    FILE *file = fopen(LOG_FILE, "r");
+    if (file == NULL) {
+        perror("fopen");
+        return;
+    }
+
+    char line[MAX_LOG_ENTRY_SIZE + 50];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        printf("%s", line);  // Print each log entry
+    }
+
+    fclose(file);
+}
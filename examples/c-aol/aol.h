@@ -0,0 +1,68 @@
+#ifndef NACC_AOL_H
+#define NACC_AOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define MAX_LOG_ENTRY_SIZE 256
+#define MAILBOX_SIZE 10
+#define LOG_FILE "log.json"
+// Line that starts a record's leaf index in LOG_FILE, as written by append_indexed_to_log
+#define LOG_INDEX_FIELD "    \"index\": "
+
+// Log entry structure
+typedef struct {
+    char log_entry[MAX_LOG_ENTRY_SIZE];
+    unsigned long timestamp;
+} LogEntry;
+
+// Mailbox structure for message passing
+typedef struct {
+    LogEntry entries[MAILBOX_SIZE];
+    int head;
+    int tail;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    bool closed;
+} Mailbox;
+
+// Initialize mailbox
+void init_mailbox(Mailbox *mailbox);
+
+// Send a log entry to the mailbox
+void send_message(Mailbox *mailbox, LogEntry entry);
+
+// Receive a log entry from the mailbox
+LogEntry receive_message(Mailbox *mailbox);
+
+// Receive a log entry, giving up at deadline (CLOCK_MONOTONIC, NULL to wait forever).
+// Returns 0 with an entry, ETIMEDOUT at the deadline, or EPIPE once the mailbox is closed and drained
+int receive_message_timed(Mailbox *mailbox, LogEntry *entry, const struct timespec *deadline);
+
+// Close the mailbox: receivers drain what is queued, then get EPIPE instead of blocking
+void close_mailbox(Mailbox *mailbox);
+
+// Check if log file is empty
+bool is_file_empty(const char *filename);
+
+// Append a preformatted JSON object to the array in the log file
+int append_json_to_log(const char *object);
+
+// Append log entry as JSON to the log file, returning 0 on success and -1 on failure
+int append_to_log(LogEntry entry);
+
+// Append log entry as JSON with its position in the verifiable log, returning 0 on success and -1 on failure
+int append_indexed_to_log(LogEntry entry, unsigned long index);
+
+// Actor thread function to handle log entries
+void *actor(void *arg);
+
+// Timestamp generator (CRDT-like ordering)
+unsigned long get_timestamp(void);
+
+// Read the log file
+void read_log(void);
+
+#endif
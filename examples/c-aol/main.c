@@ -1,169 +1,149 @@
+#include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <pthread.h>
-#include <string.h>
-#include <time.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <sys/file.h>
-#include <sys/stat.h>
-#include <stdbool.h>
-
-#define MAX_LOG_ENTRY_SIZE 256
-#define MAILBOX_SIZE 10
-#define LOG_FILE "log.json"
-
-// Log entry structure
-typedef struct {
-    char log_entry[MAX_LOG_ENTRY_SIZE];
-    unsigned long timestamp;
-} LogEntry;
-
-// Mailbox structure for message passing
-typedef struct {
-    LogEntry entries[MAILBOX_SIZE];
-    int head;
-    int tail;
-    pthread_mutex_t lock;
-    pthread_cond_t not_empty;
-    pthread_cond_t not_full;
-} Mailbox;
-
-// Initialize mailbox
-void init_mailbox(Mailbox *mailbox) {
-    mailbox->head = 0;
-    mailbox->tail = 0;
-    pthread_mutex_init(&mailbox->lock, NULL);
-    pthread_cond_init(&mailbox->not_empty, NULL);
-    pthread_cond_init(&mailbox->not_full, NULL);
-}
 
-// Send a log entry to the mailbox
-void send_message(Mailbox *mailbox, LogEntry entry) {
-    pthread_mutex_lock(&mailbox->lock);
-    while ((mailbox->tail + 1) % MAILBOX_SIZE == mailbox->head) {
-        pthread_cond_wait(&mailbox->not_full, &mailbox->lock);
+#include "aol.h"
+#include "metrics.h"
+#ifdef NACC_HAVE_VLOG
+#include "vlog.h"
+#endif
+
+#define NUM_ENTRIES 5
+#define MAX_CHECKPOINT_INTERVAL (366UL * 24 * 60 * 60)
+
+// Parse a non-negative decimal count no larger than max; -1 on a sign, junk or overflow
+static int parse_count(const char *arg, unsigned long max, unsigned long *out) {
+    char *end;
+    errno = 0;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (!isdigit((unsigned char)arg[0]) || *end != '\0' || errno == ERANGE || value > max) {
+        return -1;
     }
-    mailbox->entries[mailbox->tail] = entry;
-    mailbox->tail = (mailbox->tail + 1) % MAILBOX_SIZE;
-    pthread_cond_signal(&mailbox->not_empty);
-    pthread_mutex_unlock(&mailbox->lock);
+    *out = value;
+    return 0;
 }
 
-// Receive a log entry from the mailbox
-LogEntry receive_message(Mailbox *mailbox) {
-    pthread_mutex_lock(&mailbox->lock);
-    while (mailbox->head == mailbox->tail) {
-        pthread_cond_wait(&mailbox->not_empty, &mailbox->lock);
+#ifdef NACC_HAVE_VLOG
+// Example secp256k1 checkpoint key (replace with your actual private key)
+static const unsigned char checkpoint_key[32] = {
+    0x4c, 0x88, 0xb6, 0xa7, 0xf3, 0xd9, 0xc6, 0xa1,
+    0x12, 0x75, 0x2c, 0xb3, 0x3f, 0xf3, 0xc9, 0x4c,
+    0xc2, 0xe4, 0xd6, 0x6f, 0x63, 0xb8, 0x64, 0xa4,
+    0x39, 0x74, 0x49, 0xf0, 0xb9, 0xe1, 0x76, 0x60
+};
+
+// Verify the entries written by this run against the latest checkpoint, the
+// way an auditor would: check the checkpoint signature, then O(log n) node
+// reads per record, no rehash of the log. Returns 0 if everything verified.
+static int audit_log(const VerifiableLog *vlog, const LogEntry *entries, unsigned long first, int count) {
+    Checkpoint cp;
+    if (vlog_read_checkpoint(VLOG_CHECKPOINT_FILE, &cp) != 0) {
+        fprintf(stderr, "No checkpoint to verify against\n");
+        return -1;
     }
-    LogEntry entry = mailbox->entries[mailbox->head];
-    mailbox->head = (mailbox->head + 1) % MAILBOX_SIZE;
-    pthread_cond_signal(&mailbox->not_full);
-    pthread_mutex_unlock(&mailbox->lock);
-    return entry;
-}
 
-// Check if log file is empty
-bool is_file_empty(const char *filename) {
-    struct stat st;
-    if (stat(filename, &st) == 0) {
-        return st.st_size == 0;
+    // Inclusion proofs mean nothing against a root the writer did not sign
+    int signature_ok = vlog_verify_checkpoint(&cp, vlog->public_key, vlog->public_key_len);
+    printf("Latest checkpoint: tree_size %lu, signature %s\n", cp.tree_size,
+           signature_ok ? "valid" : "INVALID");
+    if (!signature_ok) {
+        fprintf(stderr, "Not auditing records against an unverified checkpoint\n");
+        return -1;
     }
-    return true;
-}
 
-// Append log entry as JSON to the log file
-void append_to_log(LogEntry entry) {
-    FILE *file = fopen(LOG_FILE, "r+");
-    if (file == NULL) {
-        // If the file doesn't exist, create it
-        file = fopen(LOG_FILE, "w");
-        if (file == NULL) {
-            perror("fopen");
-            exit(EXIT_FAILURE);
-        }
+    int tree_fd = open(VLOG_TREE_FILE, O_RDONLY);
+    if (tree_fd < 0) {
+        perror("open");
+        return -1;
     }
-
-    // Lock the file for writing (exclusive lock)
-    int fd = fileno(file);
-    if (flock(fd, LOCK_EX) != 0) {
-        perror("flock");
-        fclose(file);
-        exit(EXIT_FAILURE);
-    }
-
-    // Check if the file is empty
-    bool first_entry = is_file_empty(LOG_FILE);
-
-    // If it's a new file, start the JSON array
-    if (first_entry) {
-        fprintf(file, "[\n");
-    } else {
-        // Move the file pointer to just before the closing bracket
-        fseek(file, -2, SEEK_END);
-        fprintf(file, ",\n");
-    }
-
-    // Append the log entry as a JSON object
-    fprintf(file, "  {\n    \"timestamp\": %lu,\n    \"log_entry\": \"%s\"\n  }\n]", entry.timestamp, entry.log_entry);
-
-    // Unlock the file after writing
-    if (flock(fd, LOCK_UN) != 0) {
-        perror("flock");
-        fclose(file);
-        exit(EXIT_FAILURE);
-    }
-
-    fclose(file);
-}
-
-// Actor thread function to handle log entries
-void *actor(void *arg) {
-    Mailbox *mailbox = (Mailbox *)arg;
-
-    while (1) {
-        // Receive log entry from mailbox
-        LogEntry entry = receive_message(mailbox);
-        // Append entry to the log file
-        append_to_log(entry);
+    int ok = 1;
+    for (int i = 0; i < count; i++) {
+        int included = vlog_verify_record(tree_fd, &cp, first + i, &entries[i]);
+        printf("Record %lu \"%s\": %s\n", first + i, entries[i].log_entry, included ? "included" : "NOT INCLUDED");
+        ok &= included;
     }
+    int range_included = vlog_verify_range(tree_fd, &cp, first, entries, count);
+    printf("Records %lu..%lu as a range: %s\n", first, first + count - 1, range_included ? "included" : "NOT INCLUDED");
+    close(tree_fd);
+    return ok && range_included ? 0 : -1;
 }
-
-// Timestamp generator (CRDT-like ordering)
-unsigned long get_timestamp() {
-    static unsigned long lamport_clock = 0;
-    return ++lamport_clock;
-}
-
-// Read the log file
-void read_log() {
-    FILE *file = fopen(LOG_FILE, "r");
-    if (file == NULL) {
-        perror("fopen");
-        return;
+#endif
+
+int main(int argc, char **argv) {
+    int verifiable = 0;
+    unsigned long checkpoint_every = 2;
+    unsigned long checkpoint_interval = 0;
+    int opt;
+
+    // -v: verifiable mode, -n: records per checkpoint, -i: seconds per checkpoint
+    while ((opt = getopt(argc, argv, "vn:i:")) != -1) {
+        switch (opt) {
+        case 'v':
+            verifiable = 1;
+            break;
+        case 'n':
+            if (parse_count(optarg, ULONG_MAX, &checkpoint_every) != 0) {
+                fprintf(stderr, "-n must be a non-negative number of records\n");
+                return 1;
+            }
+            break;
+        case 'i':
+            if (parse_count(optarg, MAX_CHECKPOINT_INTERVAL, &checkpoint_interval) != 0) {
+                fprintf(stderr, "-i must be a number of seconds from 0 to %lu\n", MAX_CHECKPOINT_INTERVAL);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-v] [-n records_per_checkpoint] [-i seconds_per_checkpoint]\n", argv[0]);
+            return 1;
+        }
     }
 
-    char line[MAX_LOG_ENTRY_SIZE + 50];
-    while (fgets(line, sizeof(line), file) != NULL) {
-        printf("%s", line);  // Print each log entry
+#ifndef NACC_HAVE_VLOG
+    if (verifiable) {
+        fprintf(stderr, "%s: built without secp256k1, verifiable mode is unavailable\n", argv[0]);
+        return 1;
     }
+#endif
 
-    fclose(file);
-}
+    // Opt-in metrics export, see c-metrics/metrics.h
+    metrics_init_from_env();
 
-int main() {
     Mailbox mailbox;
     init_mailbox(&mailbox);
 
     // Create the actor thread to process log entries
     pthread_t actor_thread;
+#ifdef NACC_HAVE_VLOG
+    VerifiableLog vlog;
+    if (verifiable && vlog_open(&vlog, &mailbox, checkpoint_key, checkpoint_every, checkpoint_interval) != 0) {
+        return 1;
+    }
+    unsigned long first_record = verifiable ? vlog.acc.size : 0;
+
+    if (verifiable) {
+        pthread_create(&actor_thread, NULL, vlog_actor, (void *)&vlog);
+    } else {
+        pthread_create(&actor_thread, NULL, actor, (void *)&mailbox);
+    }
+#else
+    (void)checkpoint_every;
+    (void)checkpoint_interval;
     pthread_create(&actor_thread, NULL, actor, (void *)&mailbox);
+#endif
 
     // Simulate incoming requests to append to the log
-    for (int i = 0; i < 5; i++) {
+    LogEntry entries[NUM_ENTRIES];
+    for (int i = 0; i < NUM_ENTRIES; i++) {
         LogEntry entry;
         snprintf(entry.log_entry, MAX_LOG_ENTRY_SIZE, "Log entry number %d", i + 1);
         entry.timestamp = get_timestamp();
+        entries[i] = entry;
 
         // Send the log entry to the actor's mailbox
         send_message(&mailbox, entry);
@@ -175,13 +155,32 @@ int main() {
     // Allow the actor thread to process entries
     sleep(2);
 
+    if (verifiable) {
+        // The verifiable actor owns the log and its lock: let it drain the
+        // mailbox and write the final checkpoint itself rather than cancel it
+        close_mailbox(&mailbox);
+    } else {
+        // Join the actor thread (not necessary in this example as the actor runs forever)
+        pthread_cancel(actor_thread);  // Cancel the thread for cleanup
+    }
+    pthread_join(actor_thread, NULL);
+
     // Read the log
     printf("Reading the log:\n");
     read_log();
 
-    // Join the actor thread (not necessary in this example as the actor runs forever)
-    pthread_cancel(actor_thread);  // Cancel the thread for cleanup
-    pthread_join(actor_thread, NULL);
+#ifdef NACC_HAVE_VLOG
+    if (verifiable) {
+        printf("\n");
+        int audited = audit_log(&vlog, entries, first_record, NUM_ENTRIES);
+        vlog_close(&vlog);
+        if (audited != 0) {
+            return 1;
+        }
+    }
+#else
+    (void)entries;
+#endif
 
     return 0;
 }
@@ -0,0 +1,266 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vlog.h"
+#include "sign.h"
+#include "metrics.h"
+
+static void to_hex(const unsigned char *data, size_t len, char *out) {
+    for (size_t i = 0; i < len; i++) {
+        sprintf(out + 2 * i, "%02x", data[i]);
+    }
+    out[2 * len] = '\0';
+}
+
+// Flush a file (or directory) that was written through another descriptor to disk
+static int sync_path(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    int rc = fsync(fd);
+    if (rc != 0) {
+        perror("fsync");
+    }
+    close(fd);
+    return rc;
+}
+
+// Start a new checkpoint interval from now
+static void schedule_checkpoint(VerifiableLog *vlog) {
+    clock_gettime(CLOCK_MONOTONIC, &vlog->next_checkpoint);
+    vlog->next_checkpoint.tv_sec += (time_t)vlog->checkpoint_interval;
+}
+
+// Count the verifiable records in LOG_FILE, checking that their indices run 0, 1, 2, ...
+static int count_log_records(unsigned long *count) {
+    char line[MAX_LOG_ENTRY_SIZE + 64];
+    int rc = 0;
+
+    *count = 0;
+    FILE *file = fopen(LOG_FILE, "r");
+    if (file == NULL) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        perror("fopen");
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, LOG_INDEX_FIELD, sizeof(LOG_INDEX_FIELD) - 1) != 0) {
+            continue;
+        }
+        unsigned long index = strtoul(line + sizeof(LOG_INDEX_FIELD) - 1, NULL, 10);
+        if (index != *count) {
+            fprintf(stderr, "%s: record index %lu where %lu was expected\n", LOG_FILE, index, *count);
+            rc = -1;
+            break;
+        }
+        (*count)++;
+    }
+    fclose(file);
+    return rc;
+}
+
+// Open the verifiable log, resuming from VLOG_TREE_FILE if it exists
+int vlog_open(VerifiableLog *vlog, Mailbox *mailbox, const unsigned char *private_key,
+              unsigned long checkpoint_every, unsigned long checkpoint_interval) {
+    unsigned long records;
+
+    memset(vlog, 0, sizeof(*vlog));
+    if (accumulator_open(&vlog->acc, VLOG_TREE_FILE) != 0) {
+        return -1;
+    }
+
+    vlog->mailbox = mailbox;
+    vlog->checkpoint_every = checkpoint_every;
+    vlog->checkpoint_interval = checkpoint_interval;
+    schedule_checkpoint(vlog);
+    memcpy(vlog->private_key, private_key, sizeof(vlog->private_key));
+
+    if (!derive_public_key(vlog->private_key, vlog->public_key, &vlog->public_key_len)) {
+        vlog_close(vlog);
+        return -1;
+    }
+
+    // The interval restarts from this open; only the records pending since
+    // the last checkpoint written, if any, carry over towards the next one
+    if (vlog_read_checkpoint(VLOG_CHECKPOINT_FILE, &vlog->last_checkpoint) != 0) {
+        memset(&vlog->last_checkpoint, 0, sizeof(vlog->last_checkpoint));
+    }
+
+    // Leaf i must be the record with "index": i. Leaves are written before
+    // their record, so a crash in between leaves the tree ahead of the log;
+    // those leaves were never checkpointed and are dropped. Anything else
+    // means the two files do not belong together.
+    if (count_log_records(&records) != 0) {
+        vlog_close(vlog);
+        return -1;
+    }
+    if (records > vlog->acc.size || vlog->last_checkpoint.tree_size > records) {
+        fprintf(stderr, "%s holds %lu verifiable records but %s has %lu leaves and %s covers %lu\n",
+                LOG_FILE, records, VLOG_TREE_FILE, vlog->acc.size, VLOG_CHECKPOINT_FILE,
+                vlog->last_checkpoint.tree_size);
+        vlog_close(vlog);
+        return -1;
+    }
+    if (records < vlog->acc.size) {
+        fprintf(stderr, "%s: dropping %lu leaves with no record in %s\n", VLOG_TREE_FILE,
+                vlog->acc.size - records, LOG_FILE);
+        if (accumulator_truncate(&vlog->acc, records) != 0) {
+            vlog_close(vlog);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Fold an entry into the tree and append it to the log as record acc.size, checkpointing when due
+int vlog_append(VerifiableLog *vlog, LogEntry entry) {
+    unsigned char leaf[VLOG_HASH_SIZE];
+    unsigned long index = vlog->acc.size;
+
+    vlog_leaf_hash(&entry, leaf);
+    if (accumulator_append(&vlog->acc, leaf) != 0) {
+        return -1;
+    }
+    // The leaf must be on disk before its record: vlog_open only repairs a tree ahead of the log
+    if (fsync(vlog->acc.tree_fd) != 0) {
+        perror("fsync");
+        accumulator_truncate(&vlog->acc, index);
+        return -1;
+    }
+    if (append_indexed_to_log(entry, index) != 0) {
+        accumulator_truncate(&vlog->acc, index);
+        return -1;
+    }
+
+    unsigned long pending = vlog->acc.size - vlog->last_checkpoint.tree_size;
+    int due = vlog->checkpoint_every && pending >= vlog->checkpoint_every;
+    if (vlog->checkpoint_interval && pending > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > vlog->next_checkpoint.tv_sec ||
+            (now.tv_sec == vlog->next_checkpoint.tv_sec && now.tv_nsec >= vlog->next_checkpoint.tv_nsec)) {
+            due = 1;
+        }
+    }
+    return due ? vlog_checkpoint(vlog) : 0;
+}
+
+// Sign and emit a checkpoint for the current tree now
+int vlog_checkpoint(VerifiableLog *vlog) {
+    Checkpoint cp;
+    char root_hex[2 * VLOG_HASH_SIZE + 1];
+    char signature_hex[2 * VLOG_SIGNATURE_SIZE + 1];
+    unsigned char digest[VLOG_HASH_SIZE];
+    size_t signature_len = 0;
+
+    // Every leaf is synced as it is appended; the records must be too before a root covering them is signed
+    if (sync_path(LOG_FILE) != 0) {
+        return -1;
+    }
+
+    memset(&cp, 0, sizeof(cp));
+    cp.tree_size = vlog->acc.size;
+    cp.timestamp = (unsigned long)time(NULL);
+    accumulator_root(&vlog->acc, cp.root);
+
+    vlog_checkpoint_digest(&cp, digest);
+    if (!sign_message(digest, sizeof(digest), vlog->private_key, cp.signature, &signature_len)) {
+        return -1;
+    }
+    to_hex(cp.signature, VLOG_SIGNATURE_SIZE, signature_hex);
+    to_hex(cp.root, VLOG_HASH_SIZE, root_hex);
+
+    // The checkpoint goes into the log itself, between the records it covers
+    char fields[320];
+    char object[384];
+    snprintf(fields, sizeof(fields), "{\"tree_size\": %lu, \"timestamp\": %lu, \"root\": \"%s\", \"signature\": \"%s\"}",
+             cp.tree_size, cp.timestamp, root_hex, signature_hex);
+    snprintf(object, sizeof(object), "  {\n    \"checkpoint\": %s\n  }", fields);
+    if (append_json_to_log(object) != 0) {
+        return -1;
+    }
+
+    // and the latest one is kept beside it so readers need not scan the log
+    char tmp_path[] = VLOG_CHECKPOINT_FILE ".tmp";
+    FILE *file = fopen(tmp_path, "w");
+    if (file == NULL) {
+        perror("fopen");
+        return -1;
+    }
+    fprintf(file, "%s\n", fields);
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0) {
+        perror("checkpoint");
+        fclose(file);
+        return -1;
+    }
+    if (fclose(file) != 0 || rename(tmp_path, VLOG_CHECKPOINT_FILE) != 0) {
+        perror("checkpoint");
+        return -1;
+    }
+    // The rename itself is only durable once the directory is synced
+    if (sync_path(".") != 0) {
+        return -1;
+    }
+
+    vlog->last_checkpoint = cp;
+    schedule_checkpoint(vlog);
+    METRIC_INC(METRIC_VLOG_CHECKPOINTS);
+    METRIC_TRACE(vlog_checkpoint, cp.tree_size);
+    return 0;
+}
+
+// Close the verifiable log
+void vlog_close(VerifiableLog *vlog) {
+    accumulator_close(&vlog->acc);
+}
+
+// Actor thread function for verifiable mode (arg is a VerifiableLog); returns
+// once the mailbox is closed and drained, after checkpointing what is pending
+void *vlog_actor(void *arg) {
+    VerifiableLog *vlog = (VerifiableLog *)arg;
+
+    while (1) {
+        LogEntry entry;
+        unsigned long pending = vlog->acc.size - vlog->last_checkpoint.tree_size;
+
+        // While records are pending, wake when the interval runs out even if no entry arrives
+        const struct timespec *deadline = NULL;
+        if (vlog->checkpoint_interval && pending > 0) {
+            deadline = &vlog->next_checkpoint;
+        }
+
+        int rc = receive_message_timed(vlog->mailbox, &entry, deadline);
+        if (rc == 0) {
+            // Append and fold the entry; failures are reported and the actor keeps running
+            vlog_append(vlog, entry);
+        } else if (rc == ETIMEDOUT) {
+            // A failed checkpoint is retried after another interval rather than in a busy loop
+            if (vlog_checkpoint(vlog) != 0) {
+                schedule_checkpoint(vlog);
+            }
+        } else {
+            // Closed: cover whatever the count and interval left pending, on this thread
+            if (pending > 0) {
+                vlog_checkpoint(vlog);
+            }
+            return NULL;
+        }
+    }
+}
+
+// Check a checkpoint signature; returns 1 if valid, 0 otherwise
+int vlog_verify_checkpoint(const Checkpoint *cp, const unsigned char *public_key, size_t public_key_len) {
+    unsigned char digest[VLOG_HASH_SIZE];
+    vlog_checkpoint_digest(cp, digest);
+    return verify_message(digest, sizeof(digest), cp->signature, public_key, public_key_len);
+}
+
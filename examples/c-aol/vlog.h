@@ -0,0 +1,51 @@
+#ifndef NACC_VLOG_H
+#define NACC_VLOG_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "aol.h"
+#include "vlog_tree.h"
+
+// Verifiable log: every record appended to LOG_FILE is folded into the Merkle
+// tree of vlog_tree.h and carries its leaf index ("index": i), and secp256k1
+// signed checkpoints of the tree size and root are appended periodically.
+
+#define VLOG_PUBLIC_KEY_SIZE 33
+
+// Log writer state for verifiable mode; owned by a single writer thread
+typedef struct {
+    Mailbox *mailbox;
+    MerkleAccumulator acc;
+    unsigned long checkpoint_every;     // records between checkpoints, 0 to disable
+    unsigned long checkpoint_interval;  // seconds between checkpoints, 0 to disable
+    unsigned char private_key[32];
+    unsigned char public_key[VLOG_PUBLIC_KEY_SIZE];
+    size_t public_key_len;
+    Checkpoint last_checkpoint;
+    struct timespec next_checkpoint;    // CLOCK_MONOTONIC deadline of the interval, as mailbox waits take it
+} VerifiableLog;
+
+// Open the verifiable log, resuming from VLOG_TREE_FILE if it exists; fails if
+// another writer has it open or the indexed records in LOG_FILE do not match
+// the leaves of the tree. The writer lock is held until vlog_close
+int vlog_open(VerifiableLog *vlog, Mailbox *mailbox, const unsigned char *private_key,
+              unsigned long checkpoint_every, unsigned long checkpoint_interval);
+
+// Fold an entry into the tree and append it to the log as record acc.size, checkpointing when due
+int vlog_append(VerifiableLog *vlog, LogEntry entry);
+
+// Sign and emit a checkpoint for the current tree now
+int vlog_checkpoint(VerifiableLog *vlog);
+
+// Close the verifiable log
+void vlog_close(VerifiableLog *vlog);
+
+// Actor thread function for verifiable mode (arg is a VerifiableLog); returns
+// once the mailbox is closed and drained, after checkpointing what is pending
+void *vlog_actor(void *arg);
+
+// Check a checkpoint signature against the writer's serialized public key; 1 if valid
+int vlog_verify_checkpoint(const Checkpoint *cp, const unsigned char *public_key, size_t public_key_len);
+
+#endif
@@ -0,0 +1,404 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "vlog_tree.h"
+#include "keccak.h"
+
+#define CHECKPOINT_DOMAIN "nacc-checkpoint-v1"
+
+// Hash two child nodes into their parent: Keccak-256(0x01 || left || right)
+static void hash_node(const unsigned char *left, const unsigned char *right, unsigned char *out) {
+    unsigned char buffer[1 + 2 * VLOG_HASH_SIZE];
+    buffer[0] = 0x01;
+    memcpy(buffer + 1, left, VLOG_HASH_SIZE);
+    memcpy(buffer + 1 + VLOG_HASH_SIZE, right, VLOG_HASH_SIZE);
+    keccak_256(buffer, sizeof(buffer), out);
+}
+
+// Serialize a value as 8 big-endian bytes
+static void put_be64(unsigned char *out, uint64_t value) {
+    for (int i = 7; i >= 0; i--) {
+        out[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+static int from_hex(const char *hex, unsigned char *out, size_t len) {
+    if (strlen(hex) != 2 * len) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        unsigned int byte;
+        if (sscanf(hex + 2 * i, "%2x", &byte) != 1) {
+            return -1;
+        }
+        out[i] = (unsigned char)byte;
+    }
+    return 0;
+}
+
+// Largest power of two strictly below n (n >= 2), the RFC 6962 split point
+static unsigned long split_point(unsigned long n) {
+    return 1UL << (63 - __builtin_clzl(n - 1));
+}
+
+// Post-order position of the complete subtree of 2^height leaves at index.
+// Once (index + 1) << height leaves are in, the store holds 2n - popcount(n)
+// nodes ending with the chain of parents up to height ctz(n), one per level.
+static off_t node_position(unsigned height, unsigned long index) {
+    unsigned long leaves = (index + 1) << height;
+    unsigned long written = 2 * leaves - __builtin_popcountl(leaves);
+    return (off_t)(written - 1 - (__builtin_ctzl(leaves) - height));
+}
+
+static int read_node(int tree_fd, unsigned height, unsigned long index, unsigned char *out) {
+    off_t offset = node_position(height, index) * VLOG_HASH_SIZE;
+    if (pread(tree_fd, out, VLOG_HASH_SIZE, offset) != VLOG_HASH_SIZE) {
+        return -1;
+    }
+    return 0;
+}
+
+// Hash of leaves [lo, hi) read from the node store; only the peaks of a
+// partial subtree are combined, so this costs O(log n) reads
+static int subtree_hash(int tree_fd, unsigned long lo, unsigned long hi, unsigned char *out) {
+    unsigned long n = hi - lo;
+    if ((n & (n - 1)) == 0) {
+        unsigned height = __builtin_ctzl(n);
+        return read_node(tree_fd, height, lo >> height, out);
+    }
+
+    unsigned char left[VLOG_HASH_SIZE], right[VLOG_HASH_SIZE];
+    unsigned long k = split_point(n);
+    if (subtree_hash(tree_fd, lo, lo + k, left) != 0 || subtree_hash(tree_fd, lo + k, hi, right) != 0) {
+        return -1;
+    }
+    hash_node(left, right, out);
+    return 0;
+}
+
+// Hash of leaves [lo, hi), taking leaves [first, first + count) from the
+// caller and every subtree outside that range from the node store
+static int range_hash(int tree_fd, unsigned long lo, unsigned long hi, unsigned long first, unsigned long count,
+                      unsigned char leaves[][VLOG_HASH_SIZE], unsigned char *out) {
+    if (hi <= first || lo >= first + count) {
+        return subtree_hash(tree_fd, lo, hi, out);
+    }
+    if (hi - lo == 1) {
+        memcpy(out, leaves[lo - first], VLOG_HASH_SIZE);
+        return 0;
+    }
+
+    unsigned char left[VLOG_HASH_SIZE], right[VLOG_HASH_SIZE];
+    unsigned long k = split_point(hi - lo);
+    if (range_hash(tree_fd, lo, lo + k, first, count, leaves, left) != 0 ||
+        range_hash(tree_fd, lo + k, hi, first, count, leaves, right) != 0) {
+        return -1;
+    }
+    hash_node(left, right, out);
+    return 0;
+}
+
+// Hash a log entry into a Merkle leaf: Keccak-256(0x00 || be64 timestamp || log_entry)
+void vlog_leaf_hash(const LogEntry *entry, unsigned char out[VLOG_HASH_SIZE]) {
+    unsigned char buffer[1 + 8 + MAX_LOG_ENTRY_SIZE];
+    size_t len = strnlen(entry->log_entry, MAX_LOG_ENTRY_SIZE);
+
+    buffer[0] = 0x00;
+    put_be64(buffer + 1, entry->timestamp);
+    memcpy(buffer + 9, entry->log_entry, len);
+    keccak_256(buffer, (int)(9 + len), out);
+}
+
+// Number of nodes in the post-order store of a tree of leaves leaves
+static unsigned long tree_nodes(unsigned long leaves) {
+    return 2 * leaves - __builtin_popcountl(leaves);
+}
+
+// Reload the peaks for acc->size leaves; largest first, they cover consecutive leaf ranges
+static int load_peaks(MerkleAccumulator *acc) {
+    unsigned long start = 0;
+    for (int height = VLOG_MAX_HEIGHT - 1; height >= 0; height--) {
+        if (acc->size & (1UL << height)) {
+            if (read_node(acc->tree_fd, height, start >> height, acc->peaks[height]) != 0) {
+                return -1;
+            }
+            start += 1UL << height;
+        }
+    }
+    return 0;
+}
+
+// Open (or resume from) a post-order node store and rebuild the peaks
+int accumulator_open(MerkleAccumulator *acc, const char *tree_path) {
+    struct stat st;
+
+    memset(acc, 0, sizeof(*acc));
+    acc->tree_fd = open(tree_path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (acc->tree_fd < 0) {
+        perror("open");
+        return -1;
+    }
+    // One writer per store: a second appender would interleave nodes, and its
+    // torn write recovery below would cut into the first one's appends
+    if (flock(acc->tree_fd, LOCK_EX | LOCK_NB) != 0) {
+        if (errno == EWOULDBLOCK) {
+            fprintf(stderr, "%s is in use by another verifiable log writer\n", tree_path);
+        } else {
+            perror("flock");
+        }
+        accumulator_close(acc);
+        return -1;
+    }
+    if (fstat(acc->tree_fd, &st) != 0) {
+        perror("fstat");
+        accumulator_close(acc);
+        return -1;
+    }
+
+    // A tree of n leaves has 2n - popcount(n) nodes; bytes past the largest
+    // such count are a torn write and are dropped
+    unsigned long nodes = (unsigned long)st.st_size / VLOG_HASH_SIZE;
+    unsigned long leaves = (nodes + VLOG_MAX_HEIGHT) / 2;
+    while (tree_nodes(leaves) > nodes) {
+        leaves--;
+    }
+    off_t consistent = (off_t)tree_nodes(leaves) * VLOG_HASH_SIZE;
+    if (consistent != st.st_size) {
+        fprintf(stderr, "Merkle node store %s: dropping %ld bytes of a torn write\n",
+                tree_path, (long)(st.st_size - consistent));
+        if (ftruncate(acc->tree_fd, consistent) != 0) {
+            perror("ftruncate");
+            accumulator_close(acc);
+            return -1;
+        }
+    }
+
+    acc->size = leaves;
+    if (load_peaks(acc) != 0) {
+        fprintf(stderr, "Merkle node store %s is unreadable\n", tree_path);
+        accumulator_close(acc);
+        return -1;
+    }
+    return 0;
+}
+
+// Fold a leaf hash into the accumulator, persisting every completed node
+int accumulator_append(MerkleAccumulator *acc, const unsigned char leaf[VLOG_HASH_SIZE]) {
+    unsigned char nodes[VLOG_MAX_HEIGHT + 1][VLOG_HASH_SIZE];
+    int count = 0;
+    unsigned height = 0;
+
+    memcpy(nodes[count++], leaf, VLOG_HASH_SIZE);
+
+    // Merge with an equal-height peak for every trailing one bit of size
+    while (acc->size & (1UL << height)) {
+        hash_node(acc->peaks[height], nodes[count - 1], nodes[count]);
+        count++;
+        height++;
+    }
+
+    // One write per append keeps the store in post-order; a short write is
+    // cut back off so the store never holds part of an append
+    ssize_t len = (ssize_t)count * VLOG_HASH_SIZE;
+    ssize_t written = write(acc->tree_fd, nodes, len);
+    if (written != len) {
+        if (written < 0) {
+            perror("write");
+        } else {
+            fprintf(stderr, "Short write to the Merkle node store\n");
+        }
+        if (ftruncate(acc->tree_fd, (off_t)tree_nodes(acc->size) * VLOG_HASH_SIZE) != 0) {
+            perror("ftruncate");
+        }
+        return -1;
+    }
+
+    memcpy(acc->peaks[height], nodes[count - 1], VLOG_HASH_SIZE);
+    acc->size++;
+    return 0;
+}
+
+// Roll the accumulator back to its first leaves leaves, dropping later nodes from the store
+int accumulator_truncate(MerkleAccumulator *acc, unsigned long leaves) {
+    if (leaves > acc->size) {
+        return -1;
+    }
+    if (ftruncate(acc->tree_fd, (off_t)tree_nodes(leaves) * VLOG_HASH_SIZE) != 0) {
+        perror("ftruncate");
+        return -1;
+    }
+    acc->size = leaves;
+    return load_peaks(acc);
+}
+
+// Current Merkle root (Keccak-256 of the empty string for an empty tree)
+void accumulator_root(const MerkleAccumulator *acc, unsigned char root[VLOG_HASH_SIZE]) {
+    if (acc->size == 0) {
+        keccak_256((const u8 *)"", 0, root);
+        return;
+    }
+
+    // Fold peaks from the smallest up, each one the left sibling of the rest
+    int height = __builtin_ctzl(acc->size);
+    memcpy(root, acc->peaks[height], VLOG_HASH_SIZE);
+    for (height++; height < VLOG_MAX_HEIGHT; height++) {
+        if (acc->size & (1UL << height)) {
+            hash_node(acc->peaks[height], root, root);
+        }
+    }
+}
+
+// Close the node store
+void accumulator_close(MerkleAccumulator *acc) {
+    if (acc->tree_fd >= 0) {
+        close(acc->tree_fd);
+        acc->tree_fd = -1;
+    }
+}
+
+// Keccak-256 over domain || be64 tree_size || be64 timestamp || root
+void vlog_checkpoint_digest(const Checkpoint *cp, unsigned char out[VLOG_HASH_SIZE]) {
+    unsigned char buffer[sizeof(CHECKPOINT_DOMAIN) - 1 + 16 + VLOG_HASH_SIZE];
+    size_t offset = sizeof(CHECKPOINT_DOMAIN) - 1;
+
+    memcpy(buffer, CHECKPOINT_DOMAIN, offset);
+    put_be64(buffer + offset, cp->tree_size);
+    put_be64(buffer + offset + 8, cp->timestamp);
+    memcpy(buffer + offset + 16, cp->root, VLOG_HASH_SIZE);
+    keccak_256(buffer, sizeof(buffer), out);
+}
+
+// Load the most recent checkpoint from VLOG_CHECKPOINT_FILE
+int vlog_read_checkpoint(const char *path, Checkpoint *cp) {
+    char line[512];
+    char root_hex[2 * VLOG_HASH_SIZE + 1];
+    char signature_hex[2 * VLOG_SIGNATURE_SIZE + 1];
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char *got = fgets(line, sizeof(line), file);
+    fclose(file);
+    if (got == NULL) {
+        return -1;
+    }
+
+    memset(cp, 0, sizeof(*cp));
+    int fields = sscanf(line, "{\"tree_size\": %lu, \"timestamp\": %lu, \"root\": \"%64[0-9a-f]\", \"signature\": \"%128[0-9a-f]\"",
+                        &cp->tree_size, &cp->timestamp, root_hex, signature_hex);
+    // Every checkpoint is signed; one without a signature is as malformed as one without a root
+    if (fields != 4 || from_hex(root_hex, cp->root, VLOG_HASH_SIZE) != 0 ||
+        from_hex(signature_hex, cp->signature, VLOG_SIGNATURE_SIZE) != 0) {
+        fprintf(stderr, "Malformed checkpoint in %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// PATH(m, D[lo:hi]) from RFC 6962: the deepest sibling comes first
+static int build_path(int tree_fd, unsigned long index, unsigned long lo, unsigned long hi,
+                      unsigned char proof[][VLOG_HASH_SIZE], int *proof_len) {
+    if (hi - lo <= 1) {
+        return 0;
+    }
+
+    unsigned long k = split_point(hi - lo);
+    if (index < lo + k) {
+        if (build_path(tree_fd, index, lo, lo + k, proof, proof_len) != 0) {
+            return -1;
+        }
+        return subtree_hash(tree_fd, lo + k, hi, proof[(*proof_len)++]);
+    }
+    if (build_path(tree_fd, index, lo + k, hi, proof, proof_len) != 0) {
+        return -1;
+    }
+    return subtree_hash(tree_fd, lo, lo + k, proof[(*proof_len)++]);
+}
+
+// Build the audit path for leaf index in a tree of size leaves from the node store
+int vlog_inclusion_proof(int tree_fd, unsigned long index, unsigned long size,
+                         unsigned char proof[][VLOG_HASH_SIZE], int *proof_len) {
+    *proof_len = 0;
+    if (index >= size) {
+        return -1;
+    }
+    return build_path(tree_fd, index, 0, size, proof, proof_len);
+}
+
+// Check an audit path against a root; returns 1 if valid, 0 otherwise
+int vlog_verify_inclusion(const unsigned char leaf[VLOG_HASH_SIZE], unsigned long index, unsigned long size,
+                          unsigned char proof[][VLOG_HASH_SIZE], int proof_len,
+                          const unsigned char root[VLOG_HASH_SIZE]) {
+    unsigned char r[VLOG_HASH_SIZE];
+
+    if (index >= size) {
+        return 0;
+    }
+
+    unsigned long fn = index;
+    unsigned long sn = size - 1;
+    memcpy(r, leaf, VLOG_HASH_SIZE);
+
+    for (int i = 0; i < proof_len; i++) {
+        if (sn == 0) {
+            return 0;
+        }
+        if ((fn & 1) || fn == sn) {
+            hash_node(proof[i], r, r);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        } else {
+            hash_node(r, proof[i], r);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && memcmp(r, root, VLOG_HASH_SIZE) == 0;
+}
+
+// Verify that entry is record index of the checkpointed tree; returns 1 if valid
+int vlog_verify_record(int tree_fd, const Checkpoint *cp, unsigned long index, const LogEntry *entry) {
+    unsigned char leaf[VLOG_HASH_SIZE];
+    unsigned char proof[VLOG_MAX_HEIGHT][VLOG_HASH_SIZE];
+    int proof_len;
+
+    if (vlog_inclusion_proof(tree_fd, index, cp->tree_size, proof, &proof_len) != 0) {
+        return 0;
+    }
+    vlog_leaf_hash(entry, leaf);
+    return vlog_verify_inclusion(leaf, index, cp->tree_size, proof, proof_len, cp->root);
+}
+
+// Verify that entries are records [first, first + count) of the checkpointed tree; returns 1 if valid
+int vlog_verify_range(int tree_fd, const Checkpoint *cp, unsigned long first, const LogEntry *entries, unsigned long count) {
+    unsigned char root[VLOG_HASH_SIZE];
+
+    if (count == 0 || first >= cp->tree_size || count > cp->tree_size - first) {
+        return 0;
+    }
+
+    unsigned char (*leaves)[VLOG_HASH_SIZE] = malloc(count * VLOG_HASH_SIZE);
+    if (!leaves) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 0;
+    }
+    for (unsigned long i = 0; i < count; i++) {
+        vlog_leaf_hash(&entries[i], leaves[i]);
+    }
+
+    int ok = range_hash(tree_fd, 0, cp->tree_size, first, count, leaves, root) == 0 &&
+             memcmp(root, cp->root, VLOG_HASH_SIZE) == 0;
+    free(leaves);
+    return ok;
+}
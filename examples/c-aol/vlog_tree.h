@@ -0,0 +1,76 @@
+#ifndef NACC_VLOG_TREE_H
+#define NACC_VLOG_TREE_H
+
+#include "aol.h"
+
+// Merkle tree over the records of LOG_FILE (RFC 6962 shape, Keccak-256,
+// 0x00 leaf / 0x01 node prefixes). Complete subtree hashes are kept in
+// VLOG_TREE_FILE in post-order, so any record or range can be proven against
+// a checkpoint in O(log n) reads. This half needs no signing library: the
+// writer that signs checkpoints lives in vlog.h.
+
+#define VLOG_HASH_SIZE 32
+#define VLOG_SIGNATURE_SIZE 64
+#define VLOG_MAX_HEIGHT 64
+#define VLOG_TREE_FILE LOG_FILE ".tree"
+#define VLOG_CHECKPOINT_FILE LOG_FILE ".checkpoint"
+
+// Incremental Merkle accumulator: one peak per set bit of size
+typedef struct {
+    unsigned char peaks[VLOG_MAX_HEIGHT][VLOG_HASH_SIZE];
+    unsigned long size;
+    int tree_fd;
+} MerkleAccumulator;
+
+// Signed statement of the tree size and root
+typedef struct {
+    unsigned long tree_size;
+    unsigned long timestamp;
+    unsigned char root[VLOG_HASH_SIZE];
+    unsigned char signature[VLOG_SIGNATURE_SIZE];
+} Checkpoint;
+
+// Hash a log entry into a Merkle leaf
+void vlog_leaf_hash(const LogEntry *entry, unsigned char out[VLOG_HASH_SIZE]);
+
+// Open (or resume from) a post-order node store and rebuild the peaks. The store
+// is locked (flock) against other writers until accumulator_close; a torn write
+// at the end of it is truncated back to the last whole append
+int accumulator_open(MerkleAccumulator *acc, const char *tree_path);
+
+// Fold a leaf hash into the accumulator, persisting every completed node
+int accumulator_append(MerkleAccumulator *acc, const unsigned char leaf[VLOG_HASH_SIZE]);
+
+// Roll the accumulator back to its first leaves leaves, dropping later nodes from the store
+int accumulator_truncate(MerkleAccumulator *acc, unsigned long leaves);
+
+// Current Merkle root (Keccak-256 of the empty string for an empty tree)
+void accumulator_root(const MerkleAccumulator *acc, unsigned char root[VLOG_HASH_SIZE]);
+
+// Close the node store
+void accumulator_close(MerkleAccumulator *acc);
+
+// Keccak-256 digest that checkpoint signatures cover
+void vlog_checkpoint_digest(const Checkpoint *cp, unsigned char out[VLOG_HASH_SIZE]);
+
+// Load the most recent checkpoint from VLOG_CHECKPOINT_FILE; fails unless it is complete and signed
+int vlog_read_checkpoint(const char *path, Checkpoint *cp);
+
+// Build the audit path for leaf index in a tree of size leaves from the node store
+int vlog_inclusion_proof(int tree_fd, unsigned long index, unsigned long size,
+                         unsigned char proof[][VLOG_HASH_SIZE], int *proof_len);
+
+// Check an audit path against a root (RFC 9162 section 2.1.3.2); needs no node store, 1 if valid
+int vlog_verify_inclusion(const unsigned char leaf[VLOG_HASH_SIZE], unsigned long index, unsigned long size,
+                          unsigned char proof[][VLOG_HASH_SIZE], int proof_len,
+                          const unsigned char root[VLOG_HASH_SIZE]);
+
+// Verify that entry is record index of the tree cp commits to; 1 if valid. Only
+// the tree is checked: the caller must verify cp's signature first (vlog_verify_checkpoint)
+int vlog_verify_record(int tree_fd, const Checkpoint *cp, unsigned long index, const LogEntry *entry);
+
+// Verify that entries are records [first, first + count) of the tree cp commits to; 1 if
+// valid. As with vlog_verify_record, cp's signature is the caller's to check
+int vlog_verify_range(int tree_fd, const Checkpoint *cp, unsigned long first, const LogEntry *entries, unsigned long count);
+
+#endif
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vlog_tree.h"
+#include "keccak.h"
+
+// Every tree size up to MAX_LEAVES is checked; up to EXHAUSTIVE_LEAVES every
+// record and range is also tampered with, above it a deterministic sample
+#define MAX_LEAVES 300
+#define EXHAUSTIVE_LEAVES 32
+#define SAMPLES 8
+#define RESUME_EVERY 37
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                         \
+    do {                                                         \
+        if (!(cond)) {                                           \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                        \
+            fprintf(stderr, "\n");                               \
+            failures++;                                          \
+        }                                                        \
+    } while (0)
+
+static LogEntry entries[MAX_LEAVES];
+static unsigned char leaves[MAX_LEAVES][VLOG_HASH_SIZE];
+
+// Reference MTH(D[lo:hi]) straight from RFC 6962 section 2.1, without the node store
+static void naive_mth(unsigned long lo, unsigned long hi, unsigned char *out) {
+    if (hi == lo) {
+        keccak_256((const u8 *)"", 0, out);
+        return;
+    }
+    if (hi - lo == 1) {
+        memcpy(out, leaves[lo], VLOG_HASH_SIZE);
+        return;
+    }
+
+    unsigned long k = 1;
+    while (2 * k < hi - lo) {
+        k *= 2;
+    }
+    unsigned char buffer[1 + 2 * VLOG_HASH_SIZE];
+    buffer[0] = 0x01;
+    naive_mth(lo, lo + k, buffer + 1);
+    naive_mth(lo + k, hi, buffer + 1 + VLOG_HASH_SIZE);
+    keccak_256(buffer, sizeof(buffer), out);
+}
+
+// Record i of a tree of n leaves proves at index i and nowhere else, and not once altered
+static void check_record(int tree_fd, const Checkpoint *cp, unsigned long i) {
+    unsigned long n = cp->tree_size;
+
+    if (n > 1) {
+        CHECK(!vlog_verify_record(tree_fd, cp, (i + 1) % n, &entries[i]),
+              "n=%lu: record %lu accepted at index %lu", n, i, (i + 1) % n);
+    }
+
+    LogEntry tampered = entries[i];
+    tampered.log_entry[0] ^= 1;
+    CHECK(!vlog_verify_record(tree_fd, cp, i, &tampered), "n=%lu: tampered record %lu accepted", n, i);
+    tampered = entries[i];
+    tampered.timestamp++;
+    CHECK(!vlog_verify_record(tree_fd, cp, i, &tampered), "n=%lu: retimed record %lu accepted", n, i);
+}
+
+// Range [first, first + count) verifies; shifted or with one entry tampered it does not
+static void check_range(int tree_fd, const Checkpoint *cp, unsigned long first, unsigned long count) {
+    unsigned long n = cp->tree_size;
+    LogEntry tampered[MAX_LEAVES];
+
+    CHECK(vlog_verify_range(tree_fd, cp, first, &entries[first], count),
+          "n=%lu: range %lu+%lu not included", n, first, count);
+    if (first + count < n) {
+        CHECK(!vlog_verify_range(tree_fd, cp, first + 1, &entries[first], count),
+              "n=%lu: range %lu+%lu accepted at %lu", n, first, count, first + 1);
+    }
+
+    memcpy(tampered, &entries[first], count * sizeof(LogEntry));
+    tampered[count / 2].log_entry[0] ^= 1;
+    CHECK(!vlog_verify_range(tree_fd, cp, first, tampered, count),
+          "n=%lu: range %lu+%lu accepted with entry %lu tampered", n, first, count, first + count / 2);
+}
+
+int main(void) {
+    char tree_path[] = "/tmp/vlog_tree_test-XXXXXX";
+    int fd = mkstemp(tree_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    MerkleAccumulator acc;
+    Checkpoint cp;
+    unsigned char expected[VLOG_HASH_SIZE];
+    unsigned long seed = 1;
+
+    if (accumulator_open(&acc, tree_path) != 0) {
+        return 1;
+    }
+    accumulator_root(&acc, cp.root);
+    naive_mth(0, 0, expected);
+    CHECK(memcmp(cp.root, expected, VLOG_HASH_SIZE) == 0, "empty tree root is not keccak(\"\")");
+
+    for (unsigned long n = 1; n <= MAX_LEAVES; n++) {
+        LogEntry *entry = &entries[n - 1];
+        snprintf(entry->log_entry, MAX_LOG_ENTRY_SIZE, "Log entry number %lu", n);
+        entry->timestamp = 3 * n;
+        vlog_leaf_hash(entry, leaves[n - 1]);
+        if (accumulator_append(&acc, leaves[n - 1]) != 0) {
+            return 1;
+        }
+
+        // Resume through accumulator_open every so often, as a restarted writer would
+        if (n % RESUME_EVERY == 0) {
+            unsigned char before[VLOG_HASH_SIZE];
+            accumulator_root(&acc, before);
+            accumulator_close(&acc);
+            if (accumulator_open(&acc, tree_path) != 0) {
+                return 1;
+            }
+            accumulator_root(&acc, cp.root);
+            CHECK(acc.size == n && memcmp(cp.root, before, VLOG_HASH_SIZE) == 0, "n=%lu: resumed tree differs", n);
+        }
+
+        memset(&cp, 0, sizeof(cp));
+        cp.tree_size = n;
+        accumulator_root(&acc, cp.root);
+        naive_mth(0, n, expected);
+        CHECK(memcmp(cp.root, expected, VLOG_HASH_SIZE) == 0, "n=%lu: root differs from the naive MTH", n);
+
+        for (unsigned long i = 0; i < n; i++) {
+            CHECK(vlog_verify_record(acc.tree_fd, &cp, i, &entries[i]), "n=%lu: record %lu not included", n, i);
+        }
+        CHECK(!vlog_verify_record(acc.tree_fd, &cp, n, &entries[0]), "n=%lu: index past the tree accepted", n);
+
+        if (n <= EXHAUSTIVE_LEAVES) {
+            for (unsigned long first = 0; first < n; first++) {
+                check_record(acc.tree_fd, &cp, first);
+                for (unsigned long count = 1; first + count <= n; count++) {
+                    check_range(acc.tree_fd, &cp, first, count);
+                }
+            }
+        } else {
+            for (int i = 0; i < SAMPLES; i++) {
+                seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+                unsigned long first = (seed >> 33) % n;
+                unsigned long count = 1 + (seed >> 13) % (n - first);
+                check_record(acc.tree_fd, &cp, first);
+                check_range(acc.tree_fd, &cp, first, count);
+            }
+        }
+    }
+
+    // Roll back to 255 leaves, where the next append writes 9 nodes, and check
+    // that any torn prefix of that append is dropped on open
+    unsigned char root[VLOG_HASH_SIZE];
+    unsigned char junk[9 * VLOG_HASH_SIZE];
+    unsigned long kept = 255;
+    accumulator_root(&acc, root);
+    CHECK(accumulator_truncate(&acc, kept) == 0, "truncate to %lu leaves failed", kept);
+    naive_mth(0, kept, expected);
+    memset(junk, 0xee, sizeof(junk));
+    for (size_t len = 1; len < sizeof(junk); len += 7) {
+        if (write(acc.tree_fd, junk, len) != (ssize_t)len) {
+            perror("write");
+            return 1;
+        }
+        accumulator_close(&acc);
+        if (accumulator_open(&acc, tree_path) != 0) {
+            return 1;
+        }
+        accumulator_root(&acc, cp.root);
+        CHECK(acc.size == kept && memcmp(cp.root, expected, VLOG_HASH_SIZE) == 0,
+              "torn write of %zu bytes not recovered", len);
+    }
+
+    // Appending the rest again reproduces the same tree
+    for (unsigned long i = kept; i < MAX_LEAVES; i++) {
+        if (accumulator_append(&acc, leaves[i]) != 0) {
+            return 1;
+        }
+    }
+    accumulator_root(&acc, cp.root);
+    CHECK(memcmp(cp.root, root, VLOG_HASH_SIZE) == 0, "re-appended root differs");
+
+    accumulator_close(&acc);
+    unlink(tree_path);
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("vlog tree: all checks passed for 1..%d leaves\n", MAX_LEAVES);
+    return 0;
+}
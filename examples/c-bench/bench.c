@@ -0,0 +1,508 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aol.h"
+#include "vlog_tree.h"
+#include "keccak.h"
+#include "metrics.h"
+#ifdef NACC_HAVE_MERKLE
+#include "merkle.h"
+#endif
+#ifdef NACC_HAVE_SIGN
+#include "sign.h"
+#endif
+#ifdef NACC_HAVE_VLOG
+#include "vlog.h"
+#endif
+#ifdef NACC_HAVE_KEYRING
+#include "keyring.h"
+#endif
+
+#ifndef NACC_VERSION
+#define NACC_VERSION "dev"
+#endif
+#ifndef NACC_BUILD_TYPE
+#define NACC_BUILD_TYPE "unknown"
+#endif
+#ifndef NACC_BUILD_LTO
+#define NACC_BUILD_LTO 0
+#endif
+#ifndef NACC_BUILD_SANITIZE
+#define NACC_BUILD_SANITIZE ""
+#endif
+#ifdef NACC_METRICS
+#define NACC_BUILD_METRICS 1
+#else
+#define NACC_BUILD_METRICS 0
+#endif
+
+#define MAX_RESULTS 32
+#define MAX_SAMPLES (1 << 20)
+#define MERKLE_LEAVES 1024
+#define VTREE_LEAVES (1 << 16)
+#define VLOG_CHECKPOINT_EVERY 2
+#define KECCAK_SMALL 1024
+#define KECCAK_LARGE (64 * 1024)
+#define METRICS_BATCH 1000
+
+// One measured benchmark, serialized as a JSON object
+typedef struct {
+    const char *name;
+    const char *unit;
+    double value;
+    unsigned long iterations;
+    double seconds;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+} BenchResult;
+
+// Benchmark body: performs exactly one operation on ctx
+typedef void (*bench_fn)(void *ctx);
+
+static BenchResult results[MAX_RESULTS];
+static int result_count = 0;
+static double min_seconds = 0.5;
+static uint64_t *samples = NULL;
+
+// Monotonic clock in nanoseconds
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Run fn until min_seconds elapse, timing every call. If bytes_per_op is
+// non-zero the reported value is MB/s, otherwise operations per second.
+static void measure(const char *name, const char *unit, size_t bytes_per_op, bench_fn fn, void *ctx) {
+    unsigned long n = 0;
+    uint64_t start = now_ns();
+    uint64_t deadline = start + (uint64_t)(min_seconds * 1e9);
+    uint64_t end = start;
+
+    // Always take at least one sample so rates and percentiles are defined
+    do {
+        uint64_t t0 = now_ns();
+        fn(ctx);
+        end = now_ns();
+        samples[n++] = end - t0;
+    } while (n < MAX_SAMPLES && end < deadline);
+
+    qsort(samples, n, sizeof(uint64_t), compare_u64);
+
+    BenchResult *r = &results[result_count++];
+    r->name = name;
+    r->unit = unit;
+    r->iterations = n;
+    r->seconds = (double)(end - start) / 1e9;
+    r->value = bytes_per_op ? (double)bytes_per_op * n / r->seconds / 1e6 : n / r->seconds;
+    r->p50_ns = samples[n / 2];
+    r->p99_ns = samples[(n * 99) / 100];
+}
+
+static void print_result(const BenchResult *r) {
+    fprintf(stderr, "%-28s %14.2f %-8s p50 %8lu ns  p99 %8lu ns\n", r->name, r->value, r->unit,
+            (unsigned long)r->p50_ns, (unsigned long)r->p99_ns);
+}
+
+static void run_bench(const char *name, const char *unit, size_t bytes_per_op, bench_fn fn, void *ctx) {
+    measure(name, unit, bytes_per_op, fn, ctx);
+    print_result(&results[result_count - 1]);
+}
+
+// Run fn, which performs METRICS_BATCH events per call, and report the
+// mean and percentile cost of a single event in nanoseconds
+static void run_overhead(const char *name, bench_fn fn, void *ctx) {
+    measure(name, "ns/event", 0, fn, ctx);
+
+    BenchResult *r = &results[result_count - 1];
+    r->value = r->seconds * 1e9 / ((double)r->iterations * METRICS_BATCH);
+    r->p50_ns /= METRICS_BATCH;
+    r->p99_ns /= METRICS_BATCH;
+    print_result(r);
+}
+
+// Write all results as a single JSON document, headed by the build they came from
+static void write_json(FILE *out) {
+    fprintf(out, "{\n  \"suite\": \"nacc\",\n  \"version\": \"%s\",\n  \"timestamp\": %ld,\n",
+            NACC_VERSION, (long)time(NULL));
+    fprintf(out, "  \"build\": {\"type\": \"%s\", \"lto\": %s, \"sanitize\": \"%s\", \"metrics\": %s},\n",
+            NACC_BUILD_TYPE, NACC_BUILD_LTO ? "true" : "false", NACC_BUILD_SANITIZE,
+            NACC_BUILD_METRICS ? "true" : "false");
+    fprintf(out, "  \"results\": [\n");
+    for (int i = 0; i < result_count; i++) {
+        BenchResult *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.3f, \"iterations\": %lu, "
+                     "\"seconds\": %.6f, \"p50_ns\": %lu, \"p99_ns\": %lu}%s\n",
+                r->name, r->unit, r->value, r->iterations, r->seconds,
+                (unsigned long)r->p50_ns, (unsigned long)r->p99_ns, i + 1 < result_count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// Fill a buffer with deterministic pseudo random bytes
+static void fill_bytes(unsigned char *buf, size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        buf[i] = (unsigned char)(seed >> 16);
+    }
+}
+
+// --- Keccak-256 ---
+
+typedef struct {
+    unsigned char *data;
+    int len;
+    unsigned char md[32];
+} KeccakCtx;
+
+static void bench_keccak(void *arg) {
+    KeccakCtx *ctx = arg;
+    keccak_256(ctx->data, ctx->len, ctx->md);
+}
+
+// --- Merkle tree ---
+
+#ifdef NACC_HAVE_MERKLE
+typedef struct {
+    unsigned char (*values)[SHA256_DIGEST_LENGTH];
+    Node left, right, parent;
+} MerkleCtx;
+
+static void bench_merkle_build(void *arg) {
+    MerkleCtx *ctx = arg;
+    Node *root = build_merkle_tree(ctx->values, MERKLE_LEAVES);
+    free(root);
+}
+
+static void bench_merkle_hash(void *arg) {
+    MerkleCtx *ctx = arg;
+    calculate_hash(&ctx->parent, &ctx->left, &ctx->right);
+    memcpy(ctx->left.hash, ctx->parent.hash, SHA256_DIGEST_LENGTH);
+}
+#endif
+
+// --- secp256k1 ---
+
+#ifdef NACC_HAVE_SIGN
+typedef struct {
+    unsigned char private_key[32];
+    unsigned char public_key[33];
+    size_t public_key_len;
+    unsigned char hash[32];
+    unsigned char signature[64];
+    size_t signature_len;
+} SignCtx;
+
+static void bench_sign(void *arg) {
+    SignCtx *ctx = arg;
+    sign_message(ctx->hash, sizeof(ctx->hash), ctx->private_key, ctx->signature, &ctx->signature_len);
+}
+
+static void bench_verify(void *arg) {
+    SignCtx *ctx = arg;
+    if (!verify_message(ctx->hash, sizeof(ctx->hash), ctx->signature, ctx->public_key, ctx->public_key_len)) {
+        fprintf(stderr, "secp256k1 verification failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+#endif
+
+// --- Append only log ---
+
+typedef struct {
+    LogEntry entry;
+} AolCtx;
+
+static void bench_append(void *arg) {
+    AolCtx *ctx = arg;
+    ctx->entry.timestamp = get_timestamp();
+    if (append_to_log(ctx->entry) != 0) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+// --- Verifiable log ---
+
+#ifdef NACC_HAVE_VLOG
+typedef struct {
+    VerifiableLog vlog;
+    LogEntry entry;
+} VlogCtx;
+
+static void bench_vlog_append(void *arg) {
+    VlogCtx *ctx = arg;
+    ctx->entry.timestamp = get_timestamp();
+    if (vlog_append(&ctx->vlog, ctx->entry) != 0) {
+        exit(EXIT_FAILURE);
+    }
+}
+#endif
+
+typedef struct {
+    MerkleAccumulator acc;
+    Checkpoint cp;
+    LogEntry entry;
+    unsigned long next_index;
+} VtreeCtx;
+
+static void bench_vlog_verify(void *arg) {
+    VtreeCtx *ctx = arg;
+    LogEntry entry = ctx->entry;
+    unsigned long index = ctx->next_index;
+
+    // Record i was folded in with timestamp i
+    entry.timestamp = index;
+    if (!vlog_verify_record(ctx->acc.tree_fd, &ctx->cp, index, &entry)) {
+        fprintf(stderr, "vlog record verification failed\n");
+        exit(EXIT_FAILURE);
+    }
+    ctx->next_index = (index + 7919) % ctx->cp.tree_size;
+}
+
+// --- Metrics overhead ---
+
+static void bench_metrics_counter(void *arg) {
+    (void)arg;
+    for (int i = 0; i < METRICS_BATCH; i++) {
+        metrics_add(METRIC_MAILBOX_SENT, 1);
+    }
+}
+
+static void bench_metrics_timer(void *arg) {
+    (void)arg;
+    for (int i = 0; i < METRICS_BATCH; i++) {
+        uint64_t timer = metrics_timer_start();
+        metrics_timer_stop(METRIC_AOL_APPEND_LATENCY, timer);
+    }
+}
+
+// --- RSA keyring ---
+
+#ifdef NACC_HAVE_KEYRING
+typedef struct {
+    Keyring keyring;
+    gcry_sexp_t ciphertext;
+    gcry_sexp_t last_ciphertext;
+    char buffer[256];
+} KeyringCtx;
+
+static void bench_rsa_encrypt(void *arg) {
+    KeyringCtx *ctx = arg;
+    gcry_sexp_t ciphertext;
+    encrypt_message(ctx->keyring.pub_keys[0], "10", &ciphertext);
+    gcry_sexp_release(ciphertext);
+}
+
+static void bench_rsa_decrypt(void *arg) {
+    KeyringCtx *ctx = arg;
+    int saved = ctx->keyring.num_keys;
+    ctx->keyring.num_keys = 1;
+    int rc = try_decrypt_message(&ctx->keyring, ctx->ciphertext, ctx->buffer, sizeof(ctx->buffer));
+    ctx->keyring.num_keys = saved;
+    if (rc != 0) {
+        fprintf(stderr, "RSA decryption failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void bench_rsa_decrypt_keyring(void *arg) {
+    KeyringCtx *ctx = arg;
+    if (try_decrypt_message(&ctx->keyring, ctx->last_ciphertext, ctx->buffer, sizeof(ctx->buffer)) != 0) {
+        fprintf(stderr, "RSA keyring decryption failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+#endif
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-o output.json] [-t seconds_per_benchmark] [-m] [-p metrics.prom]\n", argv0);
+    fprintf(stderr, "  -m  keep metrics collection enabled while running the module benchmarks\n");
+    fprintf(stderr, "  -p  write a Prometheus snapshot of the collected metrics (implies -m)\n");
+}
+
+int main(int argc, char **argv) {
+    const char *output = NULL;
+    const char *metrics_output = NULL;
+    int collect_metrics = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:t:mp:h")) != -1) {
+        switch (opt) {
+        case 'o':
+            output = optarg;
+            break;
+        case 't':
+            min_seconds = atof(optarg);
+            if (!(min_seconds > 0)) {
+                fprintf(stderr, "-t must be a positive number of seconds\n");
+                return 1;
+            }
+            break;
+        case 'p':
+            metrics_output = optarg;
+            collect_metrics = 1;
+            break;
+        case 'm':
+            collect_metrics = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    samples = malloc(MAX_SAMPLES * sizeof(uint64_t));
+    if (!samples) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    // Cost of a metrics event while collection is disabled and enabled
+    run_overhead("metrics.counter.disabled", bench_metrics_counter, NULL);
+    run_overhead("metrics.timer.disabled", bench_metrics_timer, NULL);
+    metrics_enable(1);
+    run_overhead("metrics.counter.enabled", bench_metrics_counter, NULL);
+    run_overhead("metrics.timer.enabled", bench_metrics_timer, NULL);
+    metrics_reset();
+    metrics_enable(collect_metrics);
+
+    // Keccak-256 over a small and a large message
+    KeccakCtx keccak_ctx;
+    keccak_ctx.data = malloc(KECCAK_LARGE);
+    fill_bytes(keccak_ctx.data, KECCAK_LARGE, 1);
+    keccak_ctx.len = KECCAK_SMALL;
+    run_bench("keccak256.1KiB", "MB/s", KECCAK_SMALL, bench_keccak, &keccak_ctx);
+    keccak_ctx.len = KECCAK_LARGE;
+    run_bench("keccak256.64KiB", "MB/s", KECCAK_LARGE, bench_keccak, &keccak_ctx);
+    free(keccak_ctx.data);
+
+#ifdef NACC_HAVE_MERKLE
+    // Merkle tree build over 1024 leaves and raw node hashing
+    MerkleCtx merkle_ctx;
+    merkle_ctx.values = malloc(MERKLE_LEAVES * SHA256_DIGEST_LENGTH);
+    fill_bytes((unsigned char *)merkle_ctx.values, MERKLE_LEAVES * SHA256_DIGEST_LENGTH, 2);
+    fill_bytes(merkle_ctx.left.hash, SHA256_DIGEST_LENGTH, 3);
+    fill_bytes(merkle_ctx.right.hash, SHA256_DIGEST_LENGTH, 4);
+    run_bench("merkle.build.1024", "trees/s", 0, bench_merkle_build, &merkle_ctx);
+    run_bench("merkle.hash", "nodes/s", 0, bench_merkle_hash, &merkle_ctx);
+    free(merkle_ctx.values);
+#endif
+
+#ifdef NACC_HAVE_SIGN
+    // secp256k1 sign and verify over a Keccak-256 hash
+    SignCtx sign_ctx;
+    fill_bytes(sign_ctx.private_key, sizeof(sign_ctx.private_key), 5);
+    fill_bytes(sign_ctx.hash, sizeof(sign_ctx.hash), 6);
+    if (!derive_public_key(sign_ctx.private_key, sign_ctx.public_key, &sign_ctx.public_key_len) ||
+        !sign_message(sign_ctx.hash, sizeof(sign_ctx.hash), sign_ctx.private_key, sign_ctx.signature, &sign_ctx.signature_len)) {
+        return 1;
+    }
+    run_bench("secp256k1.sign", "ops/s", 0, bench_sign, &sign_ctx);
+    run_bench("secp256k1.verify", "ops/s", 0, bench_verify, &sign_ctx);
+#endif
+
+    // Append only log, written into a scratch directory
+    char cwd[4096];
+    char scratch[] = "/tmp/nacc-bench-XXXXXX";
+    if (!getcwd(cwd, sizeof(cwd)) || !mkdtemp(scratch) || chdir(scratch) != 0) {
+        perror("scratch directory");
+        return 1;
+    }
+    AolCtx aol_ctx;
+    snprintf(aol_ctx.entry.log_entry, MAX_LOG_ENTRY_SIZE, "benchmark log entry");
+    run_bench("aol.append", "ops/s", 0, bench_append, &aol_ctx);
+    unlink(LOG_FILE);
+
+#ifdef NACC_HAVE_VLOG
+    // Verifiable log: append, fold and checkpoint as the aol -v writer does with
+    // its default of a signed checkpoint every VLOG_CHECKPOINT_EVERY records
+    VlogCtx vlog_ctx;
+    unsigned char vlog_key[32];
+    fill_bytes(vlog_key, sizeof(vlog_key), 7);
+    if (vlog_open(&vlog_ctx.vlog, NULL, vlog_key, VLOG_CHECKPOINT_EVERY, 0) != 0) {
+        return 1;
+    }
+    vlog_ctx.entry = aol_ctx.entry;
+    run_bench("vlog.append", "ops/s", 0, bench_vlog_append, &vlog_ctx);
+    vlog_close(&vlog_ctx.vlog);
+    unlink(LOG_FILE);
+    unlink(VLOG_TREE_FILE);
+    unlink(VLOG_CHECKPOINT_FILE);
+#endif
+
+    // O(log n) record verification against a tree of VTREE_LEAVES records
+    VtreeCtx vtree_ctx;
+    if (accumulator_open(&vtree_ctx.acc, VLOG_TREE_FILE) != 0) {
+        return 1;
+    }
+    vtree_ctx.entry = aol_ctx.entry;
+    for (unsigned long i = 0; i < VTREE_LEAVES; i++) {
+        unsigned char leaf[VLOG_HASH_SIZE];
+        vtree_ctx.entry.timestamp = i;
+        vlog_leaf_hash(&vtree_ctx.entry, leaf);
+        if (accumulator_append(&vtree_ctx.acc, leaf) != 0) {
+            return 1;
+        }
+    }
+    memset(&vtree_ctx.cp, 0, sizeof(vtree_ctx.cp));
+    vtree_ctx.cp.tree_size = vtree_ctx.acc.size;
+    accumulator_root(&vtree_ctx.acc, vtree_ctx.cp.root);
+    vtree_ctx.next_index = 0;
+    run_bench("vlog.verify_record", "ops/s", 0, bench_vlog_verify, &vtree_ctx);
+    accumulator_close(&vtree_ctx.acc);
+    unlink(VLOG_TREE_FILE);
+    if (chdir(cwd) != 0 || rmdir(scratch) != 0) {
+        perror("scratch directory");
+    }
+
+#ifdef NACC_HAVE_KEYRING
+    // RSA-2048 encrypt and decrypt, with one key and with a full keyring
+    initialize_libgcrypt();
+    KeyringCtx keyring_ctx;
+    initialize_keyring(&keyring_ctx.keyring, NUM_SERVER_KEYS);
+    for (int i = 0; i < NUM_SERVER_KEYS; i++) {
+        gcry_sexp_t priv_key, pub_key;
+        generate_pgp_keypair(&priv_key, &pub_key);
+        add_key_to_keyring(&keyring_ctx.keyring, priv_key, pub_key);
+    }
+    encrypt_message(keyring_ctx.keyring.pub_keys[0], "10", &keyring_ctx.ciphertext);
+    encrypt_message(keyring_ctx.keyring.pub_keys[NUM_SERVER_KEYS - 1], "10", &keyring_ctx.last_ciphertext);
+    run_bench("rsa2048.encrypt", "ops/s", 0, bench_rsa_encrypt, &keyring_ctx);
+    run_bench("rsa2048.decrypt", "ops/s", 0, bench_rsa_decrypt, &keyring_ctx);
+    run_bench("rsa2048.decrypt.keyring5", "ops/s", 0, bench_rsa_decrypt_keyring, &keyring_ctx);
+    gcry_sexp_release(keyring_ctx.ciphertext);
+    gcry_sexp_release(keyring_ctx.last_ciphertext);
+    free_keyring(&keyring_ctx.keyring);
+#endif
+
+    free(samples);
+
+    if (metrics_output && metrics_export_file(metrics_output) != 0) {
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (output) {
+        out = fopen(output, "w");
+        if (out == NULL) {
+            perror("fopen");
+            return 1;
+        }
+    }
+    write_json(out);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return 0;
+}
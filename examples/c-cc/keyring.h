@@ -0,0 +1,38 @@
+#ifndef NACC_KEYRING_H
+#define NACC_KEYRING_H
+
+#include <stddef.h>
+#include <gcrypt.h>
+
+#define PGP_ALGO GCRY_PK_RSA
+#define NUM_SERVER_KEYS 5
+
+// Define a keyring structure for server nodes
+typedef struct {
+    gcry_sexp_t *priv_keys;
+    gcry_sexp_t *pub_keys;
+    int num_keys;
+} Keyring;
+
+// Initialize the library
+void initialize_libgcrypt(void);
+
+// Generate a PGP key pair
+void generate_pgp_keypair(gcry_sexp_t *priv_key, gcry_sexp_t *pub_key);
+
+// Initialize the keyring
+void initialize_keyring(Keyring *keyring, int num_keys);
+
+// Add a key pair to the keyring
+void add_key_to_keyring(Keyring *keyring, gcry_sexp_t priv_key, gcry_sexp_t pub_key);
+
+// Encrypt a message using the public key
+void encrypt_message(gcry_sexp_t pub_key, const char *message, gcry_sexp_t *ciphertext);
+
+// Try to decrypt the message using all the keys in the keyring
+int try_decrypt_message(Keyring *keyring, gcry_sexp_t ciphertext, char *buffer, size_t buffer_len);
+
+// Free all keyring resources
+void free_keyring(Keyring *keyring);
+
+#endif
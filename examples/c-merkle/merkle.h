@@ -0,0 +1,26 @@
+#ifndef NACC_MERKLE_H
+#define NACC_MERKLE_H
+
+#include <stddef.h>
+#include <openssl/sha.h>
+
+// Node structure for the Merkle tree
+typedef struct Node {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    struct Node *left;
+    struct Node *right;
+} Node;
+
+// Function to create a new tree node
+Node* create_node(const unsigned char* data, size_t data_len);
+
+// Function to calculate the hash of two child nodes
+void calculate_hash(Node *parent, Node *left_child, Node *right_child);
+
+// Function to build the Merkle tree from an array of values
+Node* build_merkle_tree(unsigned char values[][SHA256_DIGEST_LENGTH], int count);
+
+// Function to print the Merkle root
+void print_root(Node *root);
+
+#endif
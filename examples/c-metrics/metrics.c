@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "metrics.h"
+
+// Metric names and help text, indexed by MetricCounter / MetricHistogram
+typedef struct {
+    const char *name;
+    const char *help;
+    int is_latency;
+} MetricInfo;
+
+static const MetricInfo counter_info[METRIC_COUNTER_COUNT] = {
+    [METRIC_MAILBOX_SENT] = {"nacc_mailbox_sent_total", "Log entries enqueued into a mailbox.", 0},
+    [METRIC_MAILBOX_RECEIVED] = {"nacc_mailbox_received_total", "Log entries dequeued from a mailbox.", 0},
+    [METRIC_MAILBOX_SEND_BLOCKED] = {"nacc_mailbox_send_blocked_total", "Sends that waited on a full mailbox.", 0},
+    [METRIC_MAILBOX_RECEIVE_BLOCKED] = {"nacc_mailbox_receive_blocked_total", "Receives that waited on an empty mailbox.", 0},
+    [METRIC_AOL_APPEND_ERRORS] = {"nacc_aol_append_errors_total", "Failed appends to the log file.", 0},
+    [METRIC_SIGN_ERRORS] = {"nacc_sign_errors_total", "Failed secp256k1 signatures.", 0},
+    [METRIC_KECCAK_BYTES] = {"nacc_keccak_bytes_total", "Bytes hashed with Keccak.", 0},
+    [METRIC_MERKLE_LEAVES] = {"nacc_merkle_leaves_total", "Leaves hashed into Merkle trees.", 0},
+    [METRIC_DECRYPT_FAILURES] = {"nacc_decrypt_failures_total", "Messages no keyring key could decrypt.", 0},
+    [METRIC_DECRYPT_KEYS_TRIED] = {"nacc_decrypt_keys_tried_total", "Keyring keys tried while decrypting.", 0},
+    [METRIC_VLOG_CHECKPOINTS] = {"nacc_vlog_checkpoints_total", "Checkpoints emitted by the verifiable log.", 0},
+};
+
+static const MetricInfo histogram_info[METRIC_HISTOGRAM_COUNT] = {
+    [METRIC_MAILBOX_DEPTH] = {"nacc_mailbox_depth", "Mailbox queue depth observed at enqueue.", 0},
+    [METRIC_MAILBOX_SEND_LATENCY] = {"nacc_mailbox_send_seconds", "Time spent enqueueing, including waits on a full mailbox.", 1},
+    [METRIC_MAILBOX_RECEIVE_LATENCY] = {"nacc_mailbox_receive_seconds", "Time spent dequeueing, including waits on an empty mailbox.", 1},
+    [METRIC_AOL_APPEND_LATENCY] = {"nacc_aol_append_seconds", "Latency of record appends to the log file.", 1},
+    [METRIC_SIGN_LATENCY] = {"nacc_sign_seconds", "Latency of sign_message.", 1},
+    [METRIC_KECCAK_LATENCY] = {"nacc_keccak_seconds", "Latency of keccak.", 1},
+    [METRIC_MERKLE_BUILD_LATENCY] = {"nacc_merkle_build_seconds", "Latency of build_merkle_tree.", 1},
+    [METRIC_DECRYPT_LATENCY] = {"nacc_decrypt_seconds", "Latency of try_decrypt_message.", 1},
+};
+
+static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+_Atomic int metrics_enabled = 0;
+_Thread_local MetricsShard *metrics_tls_shard = NULL;
+
+// Shards are never freed so that totals survive thread exit
+static MetricsShard *shards = NULL;
+static pthread_mutex_t shards_lock = PTHREAD_MUTEX_INITIALIZER;
+static double seconds_per_tick = 1e-9;
+
+MetricsShard *metrics_register_shard(void) {
+    MetricsShard *shard = calloc(1, sizeof(MetricsShard));
+    if (!shard) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_lock(&shards_lock);
+    shard->next = shards;
+    shards = shard;
+    pthread_mutex_unlock(&shards_lock);
+
+    metrics_tls_shard = shard;
+    return shard;
+}
+
+// Measure clock ticks against CLOCK_MONOTONIC over a short interval
+static void calibrate_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t ticks_start = metrics_now();
+    usleep(10000);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t ticks_end = metrics_now();
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    if (ticks_end > ticks_start) {
+        seconds_per_tick = seconds / (double)(ticks_end - ticks_start);
+    }
+#endif
+}
+
+void metrics_enable(int on) {
+    static pthread_once_t calibrated = PTHREAD_ONCE_INIT;
+    if (on) {
+        pthread_once(&calibrated, calibrate_clock);
+    }
+    atomic_store(&metrics_enabled, on);
+}
+
+void metrics_reset(void) {
+    pthread_mutex_lock(&shards_lock);
+    for (MetricsShard *s = shards; s; s = s->next) {
+        for (int id = 0; id < METRIC_COUNTER_COUNT; id++) {
+            atomic_store_explicit(&s->counters[id], 0, memory_order_relaxed);
+        }
+        for (int id = 0; id < METRIC_HISTOGRAM_COUNT; id++) {
+            for (int b = 0; b < METRICS_BUCKETS; b++) {
+                atomic_store_explicit(&s->histograms[id].buckets[b], 0, memory_order_relaxed);
+            }
+            atomic_store_explicit(&s->histograms[id].sum, 0, memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&shards_lock);
+}
+
+// Midpoint of the value range covered by a bucket
+static double bucket_value(unsigned index) {
+    if (index < METRICS_SUB_BUCKETS) {
+        return index;
+    }
+    unsigned shift = index / METRICS_SUB_BUCKETS - 1;
+    uint64_t low = (uint64_t)(METRICS_SUB_BUCKETS + index % METRICS_SUB_BUCKETS) << shift;
+    return (double)low + (double)((uint64_t)1 << shift) / 2.0;
+}
+
+void metrics_write_prometheus(FILE *out) {
+    MetricsShard *head;
+    pthread_mutex_lock(&shards_lock);
+    head = shards;
+    pthread_mutex_unlock(&shards_lock);
+
+    for (int id = 0; id < METRIC_COUNTER_COUNT; id++) {
+        uint64_t total = 0;
+        for (MetricsShard *s = head; s; s = s->next) {
+            total += atomic_load_explicit(&s->counters[id], memory_order_relaxed);
+        }
+        fprintf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", counter_info[id].name, counter_info[id].help,
+                counter_info[id].name, counter_info[id].name, (unsigned long long)total);
+    }
+
+    uint64_t buckets[METRICS_BUCKETS];
+    for (int id = 0; id < METRIC_HISTOGRAM_COUNT; id++) {
+        const MetricInfo *info = &histogram_info[id];
+        double scale = info->is_latency ? seconds_per_tick : 1.0;
+        uint64_t count = 0, sum = 0;
+
+        memset(buckets, 0, sizeof(buckets));
+        for (MetricsShard *s = head; s; s = s->next) {
+            for (int b = 0; b < METRICS_BUCKETS; b++) {
+                buckets[b] += atomic_load_explicit(&s->histograms[id].buckets[b], memory_order_relaxed);
+            }
+            sum += atomic_load_explicit(&s->histograms[id].sum, memory_order_relaxed);
+        }
+
+        fprintf(out, "# HELP %s %s\n# TYPE %s summary\n", info->name, info->help, info->name);
+
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            count += buckets[b];
+        }
+        for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+            double value = 0.0;
+            if (count > 0) {
+                uint64_t rank = (uint64_t)(quantiles[q] * (double)(count - 1)) + 1;
+                uint64_t seen = 0;
+                for (int b = 0; b < METRICS_BUCKETS; b++) {
+                    seen += buckets[b];
+                    if (seen >= rank) {
+                        value = bucket_value(b) * scale;
+                        break;
+                    }
+                }
+            }
+            fprintf(out, "%s{quantile=\"%g\"} %.9g\n", info->name, quantiles[q], value);
+        }
+        fprintf(out, "%s_sum %.9g\n%s_count %llu\n", info->name, (double)sum * scale, info->name, (unsigned long long)count);
+    }
+}
+
+static const char *export_path = NULL;
+
+static void export_at_exit(void) {
+    metrics_export_file(export_path);
+}
+
+void metrics_init_from_env(void) {
+    const char *socket_path = getenv("NACC_METRICS_SOCKET");
+    export_path = getenv("NACC_METRICS_FILE");
+
+    if (socket_path || export_path) {
+        metrics_enable(1);
+    }
+    if (socket_path) {
+        metrics_serve_socket(socket_path);
+    }
+    if (export_path) {
+        atexit(export_at_exit);
+    }
+}
+
+int metrics_export_file(const char *path) {
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *file = fopen(tmp_path, "w");
+    if (file == NULL) {
+        perror("fopen");
+        return -1;
+    }
+    metrics_write_prometheus(file);
+    if (fclose(file) != 0 || rename(tmp_path, path) != 0) {
+        perror("metrics export");
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Send a whole buffer without raising SIGPIPE; -1 if the peer went away
+static int send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += sent;
+        len -= (size_t)sent;
+    }
+    return 0;
+}
+
+// Answer every connection with an HTTP/1.0 response holding one snapshot,
+// so the socket can be scraped with curl --unix-socket or a socat bridge
+static void *metrics_server(void *arg) {
+    int listen_fd = (int)(intptr_t)arg;
+
+    while (1) {
+        int conn = accept(listen_fd, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // Out of resources: back off instead of spinning on accept
+                usleep(100000);
+                continue;
+            }
+            perror("metrics accept");
+            close(listen_fd);
+            return NULL;
+        }
+
+        // Drain the request, if the client sends one
+        struct timeval timeout = {0, 100000};
+        char request[1024];
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (read(conn, request, sizeof(request)) < 0) {
+            // Clients that only read still get a snapshot
+        }
+
+        // Render the snapshot in memory, then send it; a client that has
+        // already disconnected (EPIPE) just drops its response
+        char *body = NULL;
+        size_t body_len = 0;
+        FILE *out = open_memstream(&body, &body_len);
+        if (out != NULL) {
+            fprintf(out, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n\r\n");
+            metrics_write_prometheus(out);
+            if (fclose(out) == 0) {
+                send_all(conn, body, body_len);
+            }
+            free(body);
+        }
+        close(conn);
+    }
+    return NULL;
+}
+
+int metrics_serve_socket(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Metrics socket path too long\n");
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        perror("metrics socket");
+        close(fd);
+        return -1;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, metrics_server, (void *)(intptr_t)fd) != 0) {
+        fprintf(stderr, "Failed to start metrics server\n");
+        close(fd);
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
@@ -0,0 +1,159 @@
+#ifndef NACC_METRICS_H
+#define NACC_METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// Counters: monotonically increasing event totals
+typedef enum {
+    METRIC_MAILBOX_SENT,
+    METRIC_MAILBOX_RECEIVED,
+    METRIC_MAILBOX_SEND_BLOCKED,
+    METRIC_MAILBOX_RECEIVE_BLOCKED,
+    METRIC_AOL_APPEND_ERRORS,
+    METRIC_SIGN_ERRORS,
+    METRIC_KECCAK_BYTES,
+    METRIC_MERKLE_LEAVES,
+    METRIC_DECRYPT_FAILURES,
+    METRIC_DECRYPT_KEYS_TRIED,
+    METRIC_VLOG_CHECKPOINTS,
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+// Histograms: latencies in clock ticks, or plain values such as queue depth
+typedef enum {
+    METRIC_MAILBOX_DEPTH,
+    METRIC_MAILBOX_SEND_LATENCY,
+    METRIC_MAILBOX_RECEIVE_LATENCY,
+    METRIC_AOL_APPEND_LATENCY,
+    METRIC_SIGN_LATENCY,
+    METRIC_KECCAK_LATENCY,
+    METRIC_MERKLE_BUILD_LATENCY,
+    METRIC_DECRYPT_LATENCY,
+    METRIC_HISTOGRAM_COUNT
+} MetricHistogram;
+
+// Log-linear (HDR style) buckets: 8 sub-buckets per power of two, ~12% precision
+#define METRICS_SUB_BITS 3
+#define METRICS_SUB_BUCKETS (1 << METRICS_SUB_BITS)
+#define METRICS_BUCKETS 384
+
+// Per-thread metric storage. Only the owning thread writes to a shard, so
+// updates are plain relaxed load/store pairs with no locked instructions;
+// exporters sum every shard with relaxed loads.
+typedef struct MetricsShard {
+    _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    struct {
+        _Atomic uint64_t buckets[METRICS_BUCKETS];
+        _Atomic uint64_t sum;
+    } histograms[METRIC_HISTOGRAM_COUNT];
+    struct MetricsShard *next;
+} MetricsShard;
+
+extern _Atomic int metrics_enabled;
+extern _Thread_local MetricsShard *metrics_tls_shard;
+
+// Register a shard for the calling thread (first event on each thread only)
+MetricsShard *metrics_register_shard(void);
+
+// Turn collection on or off at runtime; enabling calibrates the clock once
+void metrics_enable(int on);
+
+// Zero every shard; only meaningful while no other thread is recording
+void metrics_reset(void);
+
+// Write a snapshot of all shards in Prometheus text exposition format
+void metrics_write_prometheus(FILE *out);
+
+// Write a snapshot to path, replacing it atomically via a temporary file
+int metrics_export_file(const char *path);
+
+// Serve snapshots on a Unix socket from a background thread, one per connection
+int metrics_serve_socket(const char *path);
+
+// Enable collection when NACC_METRICS_FILE (written at exit) or
+// NACC_METRICS_SOCKET (served while running) is set in the environment
+void metrics_init_from_env(void);
+
+// Current time in clock ticks (TSC on x86-64, nanoseconds elsewhere)
+static inline uint64_t metrics_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline MetricsShard *metrics_shard(void) {
+    MetricsShard *shard = metrics_tls_shard;
+    return shard ? shard : metrics_register_shard();
+}
+
+static inline void metrics_bump(_Atomic uint64_t *slot, uint64_t n) {
+    atomic_store_explicit(slot, atomic_load_explicit(slot, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+// Map a value to its log-linear bucket
+static inline unsigned metrics_bucket(uint64_t value) {
+    if (value < METRICS_SUB_BUCKETS) {
+        return (unsigned)value;
+    }
+    unsigned msb = 63 - (unsigned)__builtin_clzll(value);
+    unsigned shift = msb - METRICS_SUB_BITS;
+    unsigned index = (shift + 1) * METRICS_SUB_BUCKETS + (unsigned)((value >> shift) & (METRICS_SUB_BUCKETS - 1));
+    return index < METRICS_BUCKETS ? index : METRICS_BUCKETS - 1;
+}
+
+static inline void metrics_add(MetricCounter id, uint64_t n) {
+    if (atomic_load_explicit(&metrics_enabled, memory_order_relaxed)) {
+        metrics_bump(&metrics_shard()->counters[id], n);
+    }
+}
+
+static inline void metrics_record(MetricHistogram id, uint64_t value) {
+    if (atomic_load_explicit(&metrics_enabled, memory_order_relaxed)) {
+        MetricsShard *shard = metrics_shard();
+        metrics_bump(&shard->histograms[id].buckets[metrics_bucket(value)], 1);
+        metrics_bump(&shard->histograms[id].sum, value);
+    }
+}
+
+static inline uint64_t metrics_timer_start(void) {
+    return atomic_load_explicit(&metrics_enabled, memory_order_relaxed) ? metrics_now() : 0;
+}
+
+static inline void metrics_timer_stop(MetricHistogram id, uint64_t start) {
+    if (start) {
+        metrics_record(id, metrics_now() - start);
+    }
+}
+
+// Hot path hooks. Building without NACC_METRICS compiles them away entirely;
+// with it, a disabled collector costs one relaxed load and a branch.
+#ifdef NACC_METRICS
+#define METRIC_INC(id) metrics_add((id), 1)
+#define METRIC_ADD(id, n) metrics_add((id), (n))
+#define METRIC_RECORD(id, value) metrics_record((id), (value))
+#define METRIC_TIMER_START(timer) uint64_t timer = metrics_timer_start()
+#define METRIC_TIMER_STOP(id, timer) metrics_timer_stop((id), (timer))
+#else
+#define METRIC_INC(id) ((void)0)
+#define METRIC_ADD(id, n) ((void)0)
+#define METRIC_RECORD(id, value) ((void)0)
+#define METRIC_TIMER_START(timer) ((void)0)
+#define METRIC_TIMER_STOP(id, timer) ((void)0)
+#endif
+
+// Optional USDT tracepoints (provider "nacc"), usable from bpftrace/perf
+#ifdef NACC_HAVE_SDT
+#include <sys/sdt.h>
+#define METRIC_TRACE(name, arg) DTRACE_PROBE1(nacc, name, arg)
+#else
+#define METRIC_TRACE(name, arg) ((void)(arg))
+#endif
+
+#endif
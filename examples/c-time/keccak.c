@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "keccak.h"
+#include "metrics.h"
+
+// Keccak round constants
+const u64 keccakf_rndc[KECCAK_ROUNDS] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+
+// Rotation constants for Keccak
+const int keccakf_rotc[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+                              27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+
+// Pi permutation for Keccak
+const int keccakf_piln[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+                              15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+// Keccak-f[1600] state permutation
+void keccakf(u64 st[25]) {
+    int i, j, r;
+    u64 t, bc[5];
+
+    for (r = 0; r < KECCAK_ROUNDS; r++) {
+        // Theta step
+        for (i = 0; i < 5; i++)
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        for (i = 0; i < 5; i++) {
+            t = bc[(i + 4) % 5] ^ ((bc[(i + 1) % 5] << 1) | (bc[(i + 1) % 5] >> (64 - 1)));
+            for (j = 0; j < 25; j += 5)
+                st[j + i] ^= t;
+        }
+
+        // Rho Pi step
+        t = st[1];
+        for (i = 0; i < 24; i++) {
+            j = keccakf_piln[i];
+            bc[0] = st[j];
+            st[j] = (t << keccakf_rotc[i]) | (t >> (64 - keccakf_rotc[i]));
+            t = bc[0];
+        }
+
+        // Chi step
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++)
+                bc[i] = st[j + i];
+            for (i = 0; i < 5; i++)
+                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+        }
+
+        // Iota step
+        st[0] ^= keccakf_rndc[r];
+    }
+}
+
+// Keccak padding and input processing
+void keccak(const u8 *in, int inlen, u8 *md, int mdlen) {
+    u64 st[25], lane;
+    u8 temp[144];
+    int i, rsiz, rsizw;
+
+    METRIC_TIMER_START(timer);
+    METRIC_ADD(METRIC_KECCAK_BYTES, inlen);
+    memset(st, 0, sizeof(st));
+
+    rsiz = 200 - 2 * mdlen;
+    rsizw = rsiz / 8;
+
+    for (; inlen >= rsiz; inlen -= rsiz, in += rsiz) {
+        for (i = 0; i < rsizw; i++) {
+            memcpy(&lane, in + 8 * i, sizeof(lane));  // input may be unaligned
+            st[i] ^= lane;
+        }
+        keccakf(st);
+    }
+
+    memcpy(temp, in, inlen);
+    temp[inlen++] = 1;
+    memset(temp + inlen, 0, rsiz - inlen);
+    temp[rsiz - 1] |= 0x80;
+
+    for (i = 0; i < rsizw; i++) {
+        memcpy(&lane, temp + 8 * i, sizeof(lane));
+        st[i] ^= lane;
+    }
+
+    keccakf(st);
+
+    memcpy(md, st, mdlen);
+    METRIC_TIMER_STOP(METRIC_KECCAK_LATENCY, timer);
+}
+
+// Keccak-256 hash function
+void keccak_256(const u8 *in, int inlen, u8 *md) {
+    keccak(in, inlen, md, 32);  // Keccak-256 produces a 32-byte (256-bit) hash
+}
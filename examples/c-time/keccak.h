@@ -0,0 +1,19 @@
+#ifndef NACC_KECCAK_H
+#define NACC_KECCAK_H
+
+#include <stdint.h>
+
+#define KECCAK_ROUNDS 24
+typedef uint64_t u64;
+typedef uint8_t u8;
+
+// Keccak-f[1600] state permutation
+void keccakf(u64 st[25]);
+
+// Keccak padding and input processing
+void keccak(const u8 *in, int inlen, u8 *md, int mdlen);
+
+// Keccak-256 hash function
+void keccak_256(const u8 *in, int inlen, u8 *md);
+
+#endif
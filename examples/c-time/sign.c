@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <secp256k1.h>
+
+#include "sign.h"
+#include "metrics.h"
+
+// Function to sign a Keccak-256 hashed message using secp256k1
+int sign_message(const unsigned char *hash, size_t hash_len, const unsigned char *private_key, unsigned char *signature, size_t *signature_len) {
+    METRIC_TIMER_START(timer);
+    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    secp256k1_ecdsa_signature sig;
+
+    // Sign the Keccak-256 hash using the private key
+    if (!secp256k1_ecdsa_sign(ctx, &sig, hash, private_key, NULL, NULL)) {
+        fprintf(stderr, "Error signing the message\n");
+        secp256k1_context_destroy(ctx);
+        METRIC_INC(METRIC_SIGN_ERRORS);
+        METRIC_TRACE(sign_error, hash_len);
+        return 0;
+    }
+
+    // Serialize the signature in compact format (64 bytes)
+    secp256k1_ecdsa_signature_serialize_compact(ctx, signature, &sig);
+
+    secp256k1_context_destroy(ctx);
+    *signature_len = 64;  // secp256k1 signature size is 64 bytes in compact form
+    METRIC_TIMER_STOP(METRIC_SIGN_LATENCY, timer);
+    return 1;
+}
+
+// Function to derive the serialized (33 byte compressed) public key for a private key
+int derive_public_key(const unsigned char *private_key, unsigned char *public_key, size_t *public_key_len) {
+    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    secp256k1_pubkey pubkey;
+
+    if (!secp256k1_ec_pubkey_create(ctx, &pubkey, private_key)) {
+        fprintf(stderr, "Error deriving the public key\n");
+        secp256k1_context_destroy(ctx);
+        return 0;
+    }
+
+    *public_key_len = 33;
+    secp256k1_ec_pubkey_serialize(ctx, public_key, public_key_len, &pubkey, SECP256K1_EC_COMPRESSED);
+
+    secp256k1_context_destroy(ctx);
+    return 1;
+}
+
+// Function to verify a compact secp256k1 signature over a Keccak-256 hash
+int verify_message(const unsigned char *hash, size_t hash_len, const unsigned char *signature, const unsigned char *public_key, size_t public_key_len) {
+    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_ecdsa_signature sig;
+    secp256k1_pubkey pubkey;
+    int ok = 0;
+
+    if (hash_len == 32 &&
+        secp256k1_ec_pubkey_parse(ctx, &pubkey, public_key, public_key_len) &&
+        secp256k1_ecdsa_signature_parse_compact(ctx, &sig, signature)) {
+        ok = secp256k1_ecdsa_verify(ctx, &sig, hash, &pubkey);
+    }
+
+    secp256k1_context_destroy(ctx);
+    return ok;
+}
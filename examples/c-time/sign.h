@@ -0,0 +1,15 @@
+#ifndef NACC_SIGN_H
+#define NACC_SIGN_H
+
+#include <stddef.h>
+
+// Function to sign a Keccak-256 hashed message using secp256k1
+int sign_message(const unsigned char *hash, size_t hash_len, const unsigned char *private_key, unsigned char *signature, size_t *signature_len);
+
+// Function to derive the serialized (33 byte compressed) public key for a private key
+int derive_public_key(const unsigned char *private_key, unsigned char *public_key, size_t *public_key_len);
+
+// Function to verify a compact secp256k1 signature over a Keccak-256 hash
+int verify_message(const unsigned char *hash, size_t hash_len, const unsigned char *signature, const unsigned char *public_key, size_t public_key_len);
+
+#endif